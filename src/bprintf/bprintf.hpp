@@ -24,10 +24,71 @@ namespace better_printf
 {
   namespace details
   {
-    void apply_formatter (
+    BPRINTF_INLINE void apply_formatter (
         formatter_context & context
       );
 
+    // Integers and enums format faster than a lookup among the already formatted arguments
+    template<typename TValue>
+    using is_cheap_to_format              = std::integral_constant<bool, std::is_integral<TValue>::value || std::is_enum<TValue>::value>;
+
+    // Strings are copied as fast from their source as from an earlier copy unless padded or cut
+    template<typename TValue>
+    using is_string                       = std::integral_constant<bool, std::is_convertible<TValue const &, cstr_type>::value || std::is_same<TValue, std::string>::value>;
+
+    template<typename TValue>
+    using enable_if_cheap_to_format_t     = std::enable_if_t<is_cheap_to_format<TValue>::value>;
+
+    template<typename TValue>
+    using enable_if_not_cheap_to_format_t = std::enable_if_t<!is_cheap_to_format<TValue>::value>;
+
+    template<typename TValue>
+    enable_if_cheap_to_format_t<TValue> format_argument (
+        formatter_context &    context
+      , TValue const &         value
+      )
+    {
+      formatters::format (context, value);
+    }
+
+    template<typename TValue>
+    enable_if_not_cheap_to_format_t<TValue> format_argument (
+        formatter_context &    context
+      , TValue const &         value
+      )
+    {
+      if (is_string<TValue>::value && context.width == 0 && context.precision == no_precision)
+      {
+        formatters::format (context, value);
+        return;
+      }
+
+      if (context.repeated && copy_formatted_argument (context))
+      {
+        return;
+      }
+
+      // The first placeholder of an argument can't tell whether it's repeated, so it's always remembered
+      auto offset   = context.chars.size ();
+      auto flushed  = context.flushed;
+
+      formatters::format (context, value);
+
+      // Output that was partly flushed can't be copied
+      if (flushed == context.flushed)
+      {
+        remember_formatted_argument (context, offset);
+      }
+    }
+
+    struct cout_sink
+    {
+      void write (chars_type const & chars)
+      {
+        write_to_cout (chars);
+      }
+    };
+
     template<typename THead, typename ...TTail>
     void apply_formatter (
         formatter_context &    context
@@ -42,7 +103,34 @@ namespace better_printf
       }
       else
       {
-        formatters::format (context, head);
+        format_argument (context, head);
+      }
+    }
+  }
+}
+
+#ifdef BPRINTF_ENABLE_RECORDER
+# include "recorder.hpp"
+#endif
+
+namespace better_printf
+{
+  namespace details
+  {
+    // bsprintf without the recorder hook, for text that belongs to a call that's already recorded
+    template<typename ...TArgs>
+    void format_chars (
+        chars_type &        chars
+      , cstr_type           format
+      , TArgs const &       ...args
+      )
+    {
+      formatter_context context (chars, format);
+
+      while (scan (context))
+      {
+        resolve_arguments (context, args...);
+        apply_formatter (context, args...);
       }
     }
   }
@@ -54,12 +142,11 @@ namespace better_printf
     , TArgs &&      ...args
     )
   {
-    details::formatter_context context (chars, format);
+#ifdef BPRINTF_ENABLE_RECORDER
+    details::record_call (format, args...);
+#endif
 
-    while (details::scan (context))
-    {
-      details::apply_formatter (context, args...);
-    }
+    details::format_chars (chars, format, args...);
   }
 
   template<typename ...TArgs>
@@ -74,6 +161,74 @@ namespace better_printf
 
     details::write_to_cout (chars);
   }
+
+  // TSink is any type with a write (chars_type const &) member, like mmap_file_sink
+  template<typename TSink, typename ...TArgs>
+  void bfprintf (
+      TSink &       sink
+    , cstr_type     format
+    , TArgs &&      ...args
+    )
+  {
+    auto & chars = details::get_thread_local_chars ();
+
+    bsprintf (chars, format, std::forward<TArgs> (args)...);
+
+    sink.write (chars);
+  }
+
+  // Streams the formatted message to sink in chunks of at most threshold chars so that
+  //  memory use is bounded regardless of the size of the arguments.
+  //  Unlike bfprintf a message may reach the sink in several writes.
+  template<typename TSink, typename ...TArgs>
+  void bfprintf_streaming (
+      TSink &       sink
+    , std::size_t   threshold
+    , cstr_type     format
+    , TArgs &&      ...args
+    )
+  {
+#ifdef BPRINTF_ENABLE_RECORDER
+    details::record_call (format, args...);
+#endif
+
+    auto & chars = details::get_thread_local_chars ();
+
+    details::formatter_context context (chars, format);
+
+    context.flush_threshold = threshold > 0 ? threshold : 1;
+    context.flush_state     = &sink;
+    context.flush           = [] (void * state, chars_type const & flushed_chars)
+      {
+        static_cast<TSink *> (state)->write (flushed_chars);
+      };
+
+    while (details::scan (context))
+    {
+      details::resolve_arguments (context, args...);
+      details::apply_formatter (context, args...);
+    }
+
+    details::flush_chars (context);
+  }
+
+  template<typename ...TArgs>
+  void bprintf_streaming (
+      std::size_t   threshold
+    , cstr_type     format
+    , TArgs &&      ...args
+    )
+  {
+    details::cout_sink sink;
+
+    bfprintf_streaming (sink, threshold, format, std::forward<TArgs> (args)...);
+  }
 }
 
+#ifdef BPRINTF_HEADER_ONLY
+# include "core.cpp"
+# include "formatters.cpp"
+# include "unicode.cpp"
+#endif
+
 #endif // BPRINTF_BPRINTF__HPP
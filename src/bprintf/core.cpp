@@ -14,167 +14,251 @@
 // limitations under the License.
 // ----------------------------------------------------------------------------------------------
 
-#include "stdafx.h"
+#ifndef BPRINTF_HEADER_ONLY
+# include "stdafx.h"
+#endif
 
 #include "core.hpp"
 #include "formatters.hpp"
 
 #include <cstdio>
+#include <cstring>
 
 namespace better_printf
 {
   namespace details
   {
-    formatter_context::formatter_context (
+    BPRINTF_INLINE formatter_context::formatter_context (
         chars_type &  chars
       , cstr_type     format
       ) noexcept
-      : chars         (chars)
-      , index         (0)
-      , right_align   (false)
-      , width         (0)
-      , current       (format ? format : "")
-      , format_begin  (current)
-      , format_end    (current)
+      : chars              (chars)
+      , argument           (0)
+      , index              (0)
+      , right_align        (false)
+      , width              (0)
+      , unit               (width_unit::bytes)
+      , precision          (no_precision)
+      , width_argument     (no_argument)
+      , precision_argument (no_argument)
+      , current            (format ? format : "")
+      , format_begin       (current)
+      , format_end         (current)
+      , flush_threshold    (no_flush_threshold)
+      , flush              (nullptr)
+      , flush_state        (nullptr)
+      , flushed            (0)
+      , formatted_count    (0)
+      , scanned_arguments  (0)
+      , repeated           (false)
     {
     }
 
-    void apply_formatter (
+    BPRINTF_INLINE void apply_formatter (
         formatter_context & context
       )
     {
+      context.precision = no_precision;
       formatters::format (context, "BPRINTF_OUT_OF_BOUNDS");
     }
 
-    bool scan (formatter_context & context)
+    BPRINTF_INLINE bool scan (formatter_context & context)
     {
-      auto current  = context.current;
+      BPRINTF_ASSERT (context.current);
 
-      BPRINTF_ASSERT (current);
+      for (;;)
+      {
+        auto token = scan_placeholder (context);
 
-      auto & chars = context.chars;
+        append_chars (context, context.current, static_cast<std::size_t> (token.literal_end - context.current));
 
-      while (*current != null_char)
-      {
-        // Not EOS
+        context.current = token.next;
 
-        if (*current != format_prelude)
+        switch (token.kind)
         {
-          // Current char isn't prelude, copy it to buffer
-          ++current;
+        case scan_kind::end:
+          return false;
+        case scan_kind::escape:
           continue;
+        case scan_kind::placeholder:
+          break;
         }
 
-        chars.insert (chars.end (), context.current, current);
+        context.argument = context.index;
 
-        // Prelude found
-        ++current;
+        // Repeats of arguments past 64 aren't detected, they're formatted again
+        auto bit = context.index < 64 ? std::uint64_t (1) << context.index : std::uint64_t (0);
 
-        if (*current == format_prelude)
-        {
-          // Next char is prelude char
-          // Double prelude char is an escape sequence, copy prelude char to buffer
-          chars.push_back (format_prelude);
-          continue;
-        }
+        context.repeated          = (context.scanned_arguments & bit) != 0;
+        context.scanned_arguments |= bit;
 
-        auto format_begin = current;
+        return true;
+      }
+    }
 
-        // Scan for epilogue char
-        while (*current != null_char && *current != format_epilogue)
-        {
-          ++current;
-        }
+    BPRINTF_INLINE bool copy_formatted_argument (formatter_context & context)
+    {
+      auto spec_size = context.format_end - context.format_begin;
 
-        if (*current == null_char)
+      for (auto iter = 0U; iter < context.formatted_count; ++iter)
+      {
+        auto & formatted = context.formatted_arguments[iter];
+
+        if (
+              formatted.argument                            == context.argument
+          &&  formatted.right_align                         == context.right_align
+          &&  formatted.width                               == context.width
+          &&  formatted.unit                                == context.unit
+          &&  formatted.precision                           == context.precision
+          &&  formatted.fill                                == context.fill
+          &&  formatted.format_end - formatted.format_begin == spec_size
+          &&  std::memcmp (formatted.format_begin, context.format_begin, spec_size) == 0
+          )
         {
-          // Found EOS, copy the incomplete format string to buffer
-          chars.insert (chars.end (), format_begin, current);
-          continue;
-        }
+          auto & chars  = context.chars ;
+          auto size     = chars.size () ;
 
-        // Found epilogue char
-        auto format_end = current;
-
-        // TODO: Manually inline
-        //  Rationale scan() has to be fast
+          // A streaming call would have to flush in the middle of the copy, its source included,
+          //  format the argument again through the chunked append instead
+          if (size + formatted.size >= context.flush_threshold)
+          {
+            return false;
+          }
 
-        auto parse_uint64 = [&] ()
-        {
-          std::uint64_t result = 0;
-          for (; format_begin < format_end && *format_begin >= zero_char && *format_begin <= nine_char; ++format_begin)
+          if (formatted.size > 0)
           {
-            result = result* 10 + (*format_begin - zero_char);
+            // Self insert isn't allowed for vectors, resize and copy instead
+            chars.resize (size + formatted.size);
+            std::memcpy (&chars[size], &chars[formatted.offset], formatted.size);
           }
-          return result;
-        };
 
-        // Parse parameter index
-        auto index  = parse_uint64 ();
-        auto width  = 0LLU;
+          return true;
+        }
+      }
 
-        auto plus_minus_token = peek_token (format_begin, format_end, plus_char, minus_char);
+      return false;
+    }
 
-        if (plus_minus_token != null_char)
-        {
-          ++format_begin;
-          width = parse_uint64 ();
-        }
+    BPRINTF_INLINE void remember_formatted_argument (
+        formatter_context & context
+      , std::size_t         offset
+      )
+    {
+      if (context.formatted_count < max_formatted_arguments)
+      {
+        auto & formatted = context.formatted_arguments[context.formatted_count++];
+
+        formatted.argument      = context.argument                ;
+        formatted.right_align   = context.right_align             ;
+        formatted.width         = context.width                   ;
+        formatted.unit          = context.unit                    ;
+        formatted.precision     = context.precision               ;
+        formatted.fill          = context.fill                    ;
+        formatted.format_begin  = context.format_begin            ;
+        formatted.format_end    = context.format_end              ;
+        formatted.offset        = offset                          ;
+        formatted.size          = context.chars.size () - offset  ;
+      }
+    }
 
-        auto colon_token = peek_token (format_begin, format_end, colon_char);
+    BPRINTF_INLINE void flush_chars (formatter_context const & context)
+    {
+      BPRINTF_ASSERT (context.flush);
 
-        if (colon_token != null_char)
-        {
-          ++format_begin;
-        }
-        else
+      auto & chars = context.chars;
+
+      if (!chars.empty ())
+      {
+        context.flush (context.flush_state, chars);
+      }
+
+      context.flushed         += chars.size ();
+      context.formatted_count = 0;
+
+      chars.clear ();
+    }
+
+    BPRINTF_INLINE void append_chars_streaming (
+        formatter_context const & context
+      , cstr_type                 begin
+      , std::size_t               size
+      )
+    {
+      auto & chars      = context.chars           ;
+      auto threshold    = context.flush_threshold ;
+
+      while (size > 0)
+      {
+        if (chars.size () >= threshold)
         {
-          // No custom format string found
-          format_begin = format_end;
+          flush_chars (context);
         }
 
-        ++current;
+        auto room   = threshold - chars.size ();
+        auto chunk  = size < room ? size : room;
 
-        context.current       = current                       ;
-        context.index         = index                         ;
-        context.width         = width                         ;
-        context.right_align   = plus_minus_token == plus_char ;
-        context.fill          = space_char                    ;
-        context.format_begin  = format_begin                  ;
-        context.format_end    = format_end                    ;
+        chars.insert (chars.end (), begin, begin + chunk);
 
-        return true;
+        begin += chunk;
+        size  -= chunk;
       }
 
-      chars.insert (chars.end (), context.current, current);
-
-      context.current = current;
-
-      return false;
+      if (chars.size () >= threshold)
+      {
+        flush_chars (context);
+      }
     }
 
-    namespace
+    BPRINTF_INLINE void append_fill_streaming (
+        formatter_context const & context
+      , std::size_t               count
+      , char_type                 fill
+      )
     {
-      chars_type create_chars ()
+      auto & chars      = context.chars           ;
+      auto threshold    = context.flush_threshold ;
+
+      while (count > 0)
       {
-        chars_type chars;
+        if (chars.size () >= threshold)
+        {
+          flush_chars (context);
+        }
+
+        auto room   = threshold - chars.size ();
+        auto chunk  = count < room ? count : room;
 
-        chars.reserve (initial_buffer);
+        chars.insert (chars.end (), chunk, fill);
 
-        return chars;
+        count -= chunk;
       }
 
-      thread_local chars_type thread_local_chars = create_chars ();
+      if (chars.size () >= threshold)
+      {
+        flush_chars (context);
+      }
+    }
+
+    BPRINTF_INLINE chars_type create_chars ()
+    {
+      chars_type chars;
+
+      chars.reserve (initial_buffer);
+
+      return chars;
     }
 
-    chars_type & get_thread_local_chars ()
+    BPRINTF_INLINE chars_type & get_thread_local_chars ()
     {
+      // Function local so that header-only builds share one buffer per thread across translation units
+      thread_local chars_type thread_local_chars = create_chars ();
+
       thread_local_chars.clear ();
 
       return thread_local_chars;
     }
 
-    void write_to_cout (chars_type const & chars)
+    BPRINTF_INLINE void write_to_cout (chars_type const & chars)
     {
       auto sz = chars.size ();
       if (sz > 0)
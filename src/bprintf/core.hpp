@@ -29,6 +29,32 @@
 # define BPRINTF_ASSERT assert
 #endif
 
+// Define BPRINTF_HEADER_ONLY to compile bprintf from the headers only
+//  The .cpp files are then included by the headers and mustn't be compiled separately
+#ifdef BPRINTF_HEADER_ONLY
+# define BPRINTF_INLINE inline
+#else
+# define BPRINTF_INLINE
+#endif
+
+// C++14 relaxed constexpr (loops and mutation), Visual Studio supports it from 2017 (v141)
+//  The scanning helpers shared with static_bsprintf are only constexpr where it's available
+//  so that the runtime formatters build with older compilers
+#if (defined(__cpp_constexpr) && __cpp_constexpr >= 201304) || (defined(_MSC_VER) && _MSC_VER >= 1910)
+# define BPRINTF_HAS_CONSTEXPR14 1
+# define BPRINTF_CONSTEXPR14 constexpr
+#else
+# define BPRINTF_CONSTEXPR14
+#endif
+
+#if defined(_MSC_VER)
+# define BPRINTF_FORCEINLINE __forceinline
+#elif defined(__GNUC__)
+# define BPRINTF_FORCEINLINE inline __attribute__ ((always_inline))
+#else
+# define BPRINTF_FORCEINLINE inline
+#endif
+
 namespace better_printf
 {
   using char_type                             = char                    ;
@@ -49,13 +75,63 @@ namespace better_printf
     constexpr char_type const   minus_char      = '-'                   ;
     constexpr char_type const   colon_char      = ':'                   ;
     constexpr char_type const   space_char      = ' '                   ;
+    constexpr char_type const   newline_char    = '\n'                  ;
+
+    constexpr char_type const   decimal_point_char    = '.'             ;
+    constexpr char_type const   group_separator_char  = ','             ;
+
+    constexpr std::size_t const max_fixed_scale       = 64              ;
+
+    constexpr std::size_t const max_formatted_arguments = 8             ;
+
+    constexpr std::size_t const max_double_precision  = 64              ;
+
+    constexpr std::size_t const no_argument           = ~std::size_t () ;
+    constexpr std::size_t const no_precision          = ~std::size_t () ;
+    constexpr std::size_t const no_flush_threshold    = ~std::size_t () ;
+
+    // What width counts when padding, selected by a u or w suffix on the width: %0+10u%
+    enum class width_unit : std::uint8_t
+    {
+      bytes       ,
+      code_points ,
+      cells       ,
+    };
+
+    // Where an argument was formatted into chars by the current call and with what spec
+    struct formatted_argument
+    {
+      std::size_t   argument      ;
+      bool          right_align   ;
+      std::size_t   width         ;
+      width_unit    unit          ;
+      std::size_t   precision     ;
+      char_type     fill          ;
+
+      cstr_type     format_begin  ;
+      cstr_type     format_end    ;
+
+      std::size_t   offset        ;
+      std::size_t   size          ;
+    };
 
     constexpr char_type const   format_prelude  = '%'                   ;
     constexpr char_type const   format_epilogue = '%'                   ;
 
+    constexpr char_type const   code_points_char  = 'u'                 ;
+    constexpr char_type const   cells_char        = 'w'                 ;
+
+    // Width and precision may be taken from an argument: %0+{2}.{3}%
+    constexpr char_type const   precision_char    = '.'                 ;
+    constexpr char_type const   argument_prelude  = '{'                 ;
+    constexpr char_type const   argument_epilogue = '}'                 ;
+
+    // Receives the formatted chars of a streaming call, see bfprintf_streaming
+    using flush_function = void (*) (void * state, chars_type const & chars);
+
     struct formatter_context
     {
-      formatter_context (
+      BPRINTF_INLINE formatter_context (
           chars_type &  chars
         , cstr_type     format
         ) noexcept;
@@ -68,21 +144,70 @@ namespace better_printf
 
       chars_type &  chars         ;
 
+      std::size_t   argument      ;
       std::size_t   index         ;
       bool          right_align   ;
       std::size_t   width         ;
+      width_unit    unit          ;
+      std::size_t   precision     ;
       char_type     fill          ;
 
+      // Arguments to take width and precision from, resolved before formatting
+      std::size_t   width_argument      ;
+      std::size_t   precision_argument  ;
+
       cstr_type     current       ;
       cstr_type     format_begin  ;
       cstr_type     format_end    ;
+
+      // Streaming calls flush chars once it reaches flush_threshold, even in the middle of an argument
+      //  Mutable as formatters flush through a const context
+      std::size_t         flush_threshold ;
+      flush_function      flush           ;
+      void *              flush_state     ;
+      mutable std::size_t flushed         ;
+
+      // Arguments formatted so far, lets repeated placeholders copy instead of format again
+      //  A flush forgets them as their output has left chars
+      mutable std::size_t formatted_count                               ;
+      formatted_argument  formatted_arguments [max_formatted_arguments] ;
+
+      // Set by scan, bit n for each argument n < 64 placeholders referred to so far
+      //  Only placeholders repeating an argument look among the formatted arguments
+      std::uint64_t       scanned_arguments ;
+      bool                repeated          ;
     };
 
-    bool scan (formatter_context & context);
+    BPRINTF_INLINE bool scan (formatter_context & context);
+
+    // Copies the output of an earlier placeholder with the same argument and spec, if any
+    BPRINTF_INLINE bool copy_formatted_argument (formatter_context & context);
+
+    BPRINTF_INLINE void remember_formatted_argument (
+        formatter_context & context
+      , std::size_t         offset
+      );
+
+    BPRINTF_INLINE void flush_chars (formatter_context const & context);
+
+    // Slow paths of append_chars and append_fill when chars would cross flush_threshold
+    BPRINTF_INLINE void append_chars_streaming (
+        formatter_context const & context
+      , cstr_type                 begin
+      , std::size_t               size
+      );
+
+    BPRINTF_INLINE void append_fill_streaming (
+        formatter_context const & context
+      , std::size_t               count
+      , char_type                 fill
+      );
+
+    BPRINTF_INLINE chars_type create_chars ();
 
-    chars_type & get_thread_local_chars ();
+    BPRINTF_INLINE chars_type & get_thread_local_chars ();
 
-    void write_to_cout (chars_type const & chars);
+    BPRINTF_INLINE void write_to_cout (chars_type const & chars);
   }
 }
 
@@ -0,0 +1,149 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_ENUM_NAMES__HPP
+#define BPRINTF_ENUM_NAMES__HPP
+
+#include "core.hpp"
+
+#include <type_traits>
+
+// BPRINTF_ENUM registers the names of an enum so bprintf formats them instead of the
+// numeric value. Use it at global scope with the fully qualified enum name:
+//
+//    enum class color { red, green, blue };
+//    BPRINTF_ENUM (color, red, green, blue)
+//
+//    bprintf ("%0%\n", color::green); // green
+//
+// Values that aren't registered are formatted as their underlying integer.
+// Up to 32 names per enum are supported.
+
+namespace better_printf
+{
+  namespace details
+  {
+    template<typename TEnum>
+    struct enum_name
+    {
+      TEnum         value ;
+      cstr_type     name  ;
+      std::size_t   size  ;
+    };
+
+    template<typename TEnum>
+    struct enum_table
+    {
+      enum_name<TEnum> const *  names ;
+      std::size_t               size  ;
+    };
+
+    // Specialized by BPRINTF_ENUM, unregistered enums have no names
+    template<typename TEnum>
+    struct enum_names
+    {
+      static constexpr enum_table<TEnum> table () noexcept
+      {
+        return enum_table<TEnum> { nullptr, 0 };
+      }
+    };
+
+    // Finds the name of value, nullptr if it has none
+    //  Dense enums registered in declaration order hit on the first compare
+    template<typename TEnum>
+    BPRINTF_FORCEINLINE enum_name<TEnum> const * find_enum_name (TEnum value) noexcept
+    {
+      auto table  = enum_names<TEnum>::table ();
+      auto index  = static_cast<std::size_t> (value);
+
+      if (index < table.size && table.names[index].value == value)
+      {
+        return table.names + index;
+      }
+
+      for (auto iter = 0U; iter < table.size; ++iter)
+      {
+        if (table.names[iter].value == value)
+        {
+          return table.names + iter;
+        }
+      }
+
+      return nullptr;
+    }
+  }
+}
+
+// MSVC passes __VA_ARGS__ on as a single argument unless it's expanded again
+#define BPRINTF_ENUM_EXPAND(x) x
+
+#define BPRINTF_ENUM_ENTRY(type, value) ::better_printf::details::enum_name<type> { type::value, #value, sizeof (#value) - 1 },
+
+#define BPRINTF_ENUM_1(type, value)       BPRINTF_ENUM_ENTRY (type, value)
+#define BPRINTF_ENUM_2(type, value, ...)  BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_1 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_3(type, value, ...)  BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_2 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_4(type, value, ...)  BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_3 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_5(type, value, ...)  BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_4 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_6(type, value, ...)  BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_5 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_7(type, value, ...)  BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_6 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_8(type, value, ...)  BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_7 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_9(type, value, ...)  BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_8 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_10(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_9 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_11(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_10 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_12(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_11 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_13(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_12 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_14(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_13 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_15(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_14 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_16(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_15 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_17(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_16 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_18(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_17 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_19(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_18 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_20(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_19 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_21(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_20 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_22(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_21 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_23(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_22 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_24(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_23 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_25(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_24 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_26(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_25 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_27(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_26 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_28(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_27 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_29(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_28 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_30(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_29 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_31(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_30 (type, __VA_ARGS__))
+#define BPRINTF_ENUM_32(type, value, ...) BPRINTF_ENUM_ENTRY (type, value) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_31 (type, __VA_ARGS__))
+
+#define BPRINTF_ENUM_SELECT(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, name, ...) name
+
+#define BPRINTF_ENUM_ENTRIES(type, ...) BPRINTF_ENUM_EXPAND (BPRINTF_ENUM_SELECT (__VA_ARGS__, BPRINTF_ENUM_32, BPRINTF_ENUM_31, BPRINTF_ENUM_30, BPRINTF_ENUM_29, BPRINTF_ENUM_28, BPRINTF_ENUM_27, BPRINTF_ENUM_26, BPRINTF_ENUM_25, BPRINTF_ENUM_24, BPRINTF_ENUM_23, BPRINTF_ENUM_22, BPRINTF_ENUM_21, BPRINTF_ENUM_20, BPRINTF_ENUM_19, BPRINTF_ENUM_18, BPRINTF_ENUM_17, BPRINTF_ENUM_16, BPRINTF_ENUM_15, BPRINTF_ENUM_14, BPRINTF_ENUM_13, BPRINTF_ENUM_12, BPRINTF_ENUM_11, BPRINTF_ENUM_10, BPRINTF_ENUM_9, BPRINTF_ENUM_8, BPRINTF_ENUM_7, BPRINTF_ENUM_6, BPRINTF_ENUM_5, BPRINTF_ENUM_4, BPRINTF_ENUM_3, BPRINTF_ENUM_2, BPRINTF_ENUM_1) (type, __VA_ARGS__))
+
+#define BPRINTF_ENUM(type, ...)                                                                         \
+  namespace better_printf                                                                               \
+  {                                                                                                     \
+    namespace details                                                                                   \
+    {                                                                                                   \
+      template<>                                                                                        \
+      struct enum_names<type>                                                                           \
+      {                                                                                                 \
+        static enum_table<type> table () noexcept                                                       \
+        {                                                                                               \
+          static constexpr enum_name<type> const names[] = { BPRINTF_ENUM_ENTRIES (type, __VA_ARGS__) }; \
+          return enum_table<type> { names, sizeof (names) / sizeof (names[0]) };                        \
+        }                                                                                               \
+      };                                                                                                \
+    }                                                                                                   \
+  }
+
+#endif // BPRINTF_ENUM_NAMES__HPP
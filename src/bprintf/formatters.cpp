@@ -14,48 +14,29 @@
 // limitations under the License.
 // ----------------------------------------------------------------------------------------------
 
-#include "stdafx.h"
+#ifndef BPRINTF_HEADER_ONLY
+# include "stdafx.h"
+#endif
 
 #include "formatters.hpp"
 
 #include <algorithm>
+#include <cstdio>
 
 namespace better_printf
 {
   namespace details
   {
-    namespace
+    // Not an anonymous namespace as header-only builds define inline functions that use it
+    namespace impl
     {
-      char_type table__i_to_char []
-      {
-        '0' ,
-        '1' ,
-        '2' ,
-        '3' ,
-        '4' ,
-        '5' ,
-        '6' ,
-        '7' ,
-        '8' ,
-        '9' ,
-        'A' ,
-        'B' ,
-        'C' ,
-        'D' ,
-        'E' ,
-        'F' ,
-      };
-
       template<std::uint64_t divisor>
-      inline void format__integral_impl (
+      BPRINTF_FORCEINLINE void format__integral_impl (
           formatter_context const & context
         , char_type                 prefix
         , std::uint64_t             value
         )
       {
-        static_assert (divisor >= 8U  , "divisor must be greater or equalt to 8");
-        static_assert (divisor <= 16U , "divisor must be lesser or equal to 16");
-
         BPRINTF_ASSERT (context.format_begin);
         BPRINTF_ASSERT (context.format_end);
 
@@ -64,23 +45,182 @@ namespace better_printf
         constexpr auto buffer_size = 23U;
         char_type buffer[buffer_size];
 
-        auto begin = buffer_size;
+        auto begin = format_digits<divisor> (buffer, buffer_size, value);
+
+        if (prefix != null_char)
+        {
+          buffer[--begin] = prefix;
+        }
+
+        details::push_buffer (context, buffer + begin, buffer_size - begin);
+      }
+
+      BPRINTF_FORCEINLINE std::uint64_t pow10 (std::size_t exponent) noexcept
+      {
+        BPRINTF_ASSERT (exponent < 20U);
+
+        std::uint64_t result = 1U;
+        for (auto iter = 0U; iter < exponent; ++iter)
+        {
+          result *= 10U;
+        }
+
+        return result;
+      }
+
+      // Writes value as at least count decimal digits, zero padded, backwards into buffer ending at begin
+      BPRINTF_FORCEINLINE std::size_t format_digits_padded (
+          char_type *     buffer
+        , std::size_t     begin
+        , std::uint64_t   value
+        , std::size_t     count
+        ) noexcept
+      {
+        auto end  = begin;
+        begin     = format_digits<10U> (buffer, begin, value);
+
+        while (end - begin < count)
+        {
+          buffer[--begin] = zero_char;
+        }
+
+        return begin;
+      }
+
+      inline void format__fixed_impl (
+          formatter_context const & context
+        , char_type                 prefix
+        , std::uint64_t             value
+        , std::size_t               scale
+        , bool                      trim
+        , bool                      group
+        )
+      {
+        BPRINTF_ASSERT (context.format_begin);
+        BPRINTF_ASSERT (context.format_end);
+        BPRINTF_ASSERT (scale <= max_fixed_scale);
+
+        // 96 is enough for scaled decimal + prefix
+        //  Rationale: 64 fraction digits + 1 decimal point + 20 integer digits + 6 group separators + 1 prefix = 92 chars
+        constexpr auto buffer_size = 96U;
+        char_type buffer[buffer_size];
+
+        auto begin  = buffer_size;
+        auto end    = buffer_size;
+
+        if (scale > 0)
+        {
+          // 10^20 overflows std::uint64_t, from scale 20 up every digit is a fraction digit
+          auto fraction = value;
+          if (scale < 20U)
+          {
+            auto divisor  = pow10 (scale);
+            fraction      = value % divisor;
+            value         = value / divisor;
+          }
+          else
+          {
+            value         = 0;
+          }
+
+          begin = format_digits_padded (buffer, begin, fraction, scale);
+
+          if (trim)
+          {
+            while (end > begin && buffer[end - 1] == zero_char)
+            {
+              --end;
+            }
+          }
 
-        do
+          // Drop the decimal point as well if all fraction digits were trimmed
+          if (end > begin)
+          {
+            buffer[--begin] = decimal_point_char;
+          }
+        }
+
+        if (group)
         {
-          buffer[--begin] = table__i_to_char[value % divisor];
-          value           = value / divisor;
-        } while (value != 0);
+          for (; value >= 1000U; value /= 1000U)
+          {
+            begin           = format_digits_padded (buffer, begin, value % 1000U, 3U);
+            buffer[--begin] = group_separator_char;
+          }
+        }
+
+        begin = format_digits<10U> (buffer, begin, value);
 
         if (prefix != null_char)
         {
           buffer[--begin] = prefix;
         }
 
-        details::push_buffer (context, buffer + begin, buffer_size - begin);
+        details::push_buffer (context, buffer + begin, end - begin);
+      }
+
+      inline void format__fixed (
+          formatter_context const & context
+        , char_type                 prefix
+        , std::uint64_t             value
+        )
+      {
+        BPRINTF_ASSERT (context.format_begin);
+        BPRINTF_ASSERT (context.format_end);
+
+        // Fixed point format: d<scale>[t][,]
+        //  scale - number of implied decimals
+        //  t     - trim trailing zeros of the fraction
+        //  ,     - group integer digits by thousands
+        auto current  = context.format_begin + 1;
+        auto end      = context.format_end;
+
+        // Saturates above max_fixed_scale so long digit runs can't overflow
+        std::size_t scale = 0;
+        for (; current < end && *current >= zero_char && *current <= nine_char; ++current)
+        {
+          scale = scale <= max_fixed_scale
+            ? scale * 10U + (*current - zero_char)
+            : scale
+            ;
+        }
+
+        // Scales above max_fixed_scale are rejected, the value is formatted as a plain integer
+        if (scale > max_fixed_scale)
+        {
+          format__integral_impl<10U> (context, prefix, value);
+          return;
+        }
+
+        auto trim   = false;
+        auto group  = false;
+
+        for (; current < end; ++current)
+        {
+          switch (*current)
+          {
+          case 't':
+            trim = true;
+            break;
+          case group_separator_char:
+            group = true;
+            break;
+          default:
+            break;
+          }
+        }
+
+        format__fixed_impl (
+            context
+          , prefix
+          , value
+          , scale
+          , trim
+          , group
+          );
       }
 
-      inline void format__integral (
+      BPRINTF_FORCEINLINE void format__integral (
           formatter_context const & context
         , char_type                 prefix
         , std::uint64_t             value
@@ -101,6 +241,15 @@ namespace better_printf
           format__integral_impl<8U>   (context, prefix, value);
           break;
         case 'd':
+          if (context.format_end - context.format_begin > 1)
+          {
+            format__fixed (context, prefix, value);
+          }
+          else
+          {
+            format__integral_impl<10U>  (context, prefix, value);
+          }
+          break;
         default:
           format__integral_impl<10U>  (context, prefix, value);
           break;
@@ -109,7 +258,7 @@ namespace better_printf
 
     }
 
-    void format__uint64 (
+    BPRINTF_INLINE void format__uint64 (
         formatter_context const & context
       , std::uint64_t             value
       )
@@ -117,10 +266,10 @@ namespace better_printf
       BPRINTF_ASSERT (context.format_begin);
       BPRINTF_ASSERT (context.format_end);
 
-      details::format__integral (context, null_char, value);
+      impl::format__integral (context, null_char, value);
     }
 
-    void format__int64 (
+    BPRINTF_INLINE void format__int64 (
         formatter_context const & context
       , std::int64_t              value
       )
@@ -128,14 +277,17 @@ namespace better_printf
       BPRINTF_ASSERT (context.format_begin);
       BPRINTF_ASSERT (context.format_end);
 
-      details::format__integral (
+      // Negating in unsigned arithmetic, -value overflows for INT64_MIN
+      auto magnitude = static_cast<std::uint64_t> (value);
+
+      impl::format__integral (
           context
-        , value < 0 ? minus_char : null_char
-        , value < 0 ? -value     : value
+        , value < 0 ? minus_char    : null_char
+        , value < 0 ? 0U - magnitude : magnitude
         );
     }
 
-    void format__double (
+    BPRINTF_INLINE void format__double (
         formatter_context const & context
       , double                    value
       )
@@ -145,40 +297,62 @@ namespace better_printf
 
       auto token = peek_token (context.format_begin, context.format_end);
 
-      auto formatter = [=] (char_type token)
+      auto precise    = context.precision != no_precision;
+
+      auto formatter  = [=] (char_type token)
       {
         switch (token)
         {
         case 'a':
         case 'A':
-          return "%a";
+          return precise ? "%.*a" : "%a";
         case 'e':
         case 'E':
-          return "%e";
+          return precise ? "%.*e" : "%e";
         case 'f':
         case 'F':
-          return "%f";
+          return precise ? "%.*f" : "%f";
         case 'g':
-          return "%g";
+          return precise ? "%.*g" : "%g";
         case 'G':
-          return "%G";
+          return precise ? "%.*G" : "%G";
         default:
-          return "%f";
+          return precise ? "%.*f" : "%f";
         }
       } (token);
 
       // TODO: Don't use sprintf
-      constexpr auto buffer_size = 64U;
+      // 512 is enough for %f of DBL_MAX with max_double_precision decimals
+      //  Rationale: 309 integer digits + 1 sign + 1 decimal point + 64 decimals = 375 chars
+      constexpr auto buffer_size = 512U;
       char_type buffer[buffer_size];
 
-      auto sz = sprintf (buffer, formatter, value);
-      details::push_buffer (context, buffer, sz);
+      auto precision  = context.precision < max_double_precision
+        ? context.precision
+        : max_double_precision
+        ;
+
+      auto sz = precise
+        ? std::snprintf (buffer, buffer_size, formatter, static_cast<int> (precision), value)
+        : std::snprintf (buffer, buffer_size, formatter, value)
+        ;
+
+      if (sz < 0)
+      {
+        sz = 0;
+      }
+      else if (sz >= static_cast<int> (buffer_size))
+      {
+        sz = buffer_size - 1;
+      }
+
+      details::push_buffer (context, buffer, static_cast<std::size_t> (sz));
     }
   }
 
   namespace formatters
   {
-    void format (
+    BPRINTF_INLINE void format (
         details::formatter_context const &  context
       , cstr_type                           value
       )
@@ -189,7 +363,7 @@ namespace better_printf
       details::push_cstr (context, value ? value : "");
     }
 
-    void format (
+    BPRINTF_INLINE void format (
         details::formatter_context const & context
       , std::string const &                 value
       )
@@ -197,7 +371,7 @@ namespace better_printf
       BPRINTF_ASSERT (context.format_begin);
       BPRINTF_ASSERT (context.format_end);
 
-      details::push_buffer (context, value.data (), value.size ());
+      details::push_string (context, value.data (), value.size ());
     }
   }
 }
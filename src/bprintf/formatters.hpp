@@ -18,6 +18,8 @@
 #define BPRINTF_FORMATTERS__HPP
 
 #include "core.hpp"
+#include "enum_names.hpp"
+#include "unicode.hpp"
 
 #include <cstring>
 #include <string>
@@ -35,6 +37,54 @@ namespace better_printf
     template<typename TFloat>
     using enable_if_floating_point_t    = std::enable_if_t<std::is_floating_point<TFloat>::value>;
 
+    template<typename TEnum>
+    using enable_if_enum_t              = std::enable_if_t<std::is_enum<TEnum>::value>;
+
+    // Width and precision taken from an argument must be integral, negative values count as zero
+    template<typename TValue>
+    constexpr std::enable_if_t<std::is_integral<TValue>::value && std::is_signed<TValue>::value, std::size_t> argument_value (
+        TValue const &         value
+      ) noexcept
+    {
+      return value < 0 ? 0U : static_cast<std::size_t> (value);
+    }
+
+    template<typename TValue>
+    constexpr std::enable_if_t<std::is_integral<TValue>::value && std::is_unsigned<TValue>::value, std::size_t> argument_value (
+        TValue const &         value
+      ) noexcept
+    {
+      return static_cast<std::size_t> (value);
+    }
+
+    template<typename TValue>
+    constexpr std::enable_if_t<!std::is_integral<TValue>::value, std::size_t> argument_value (
+        TValue const &
+      ) noexcept
+    {
+      return 0U;
+    }
+
+    constexpr std::size_t find_argument_value (
+        std::size_t
+      ) noexcept
+    {
+      return 0U;
+    }
+
+    template<typename THead, typename ...TTail>
+    constexpr std::size_t find_argument_value (
+        std::size_t            index
+      , THead const &          head
+      , TTail const &       ...tail
+      ) noexcept
+    {
+      return index != 0
+        ? find_argument_value (index - 1, tail...)
+        : argument_value (head)
+        ;
+    }
+
     constexpr char_type test_token (char_type)
     {
       return null_char;
@@ -78,33 +128,322 @@ namespace better_printf
         ;
     }
 
-    inline void push_buffer (
+    // Shared by scan () and static_scan (), constexpr where relaxed constexpr is available so static_bsprintf can use them
+
+    BPRINTF_FORCEINLINE BPRINTF_CONSTEXPR14 std::uint64_t parse_uint64 (
+        cstr_type & begin
+      , cstr_type   end
+      ) noexcept
+    {
+      std::uint64_t result = 0;
+      for (; begin < end && *begin >= zero_char && *begin <= nine_char; ++begin)
+      {
+        result = result * 10 + (*begin - zero_char);
+      }
+      return result;
+    }
+
+    // Parses either digits or {argument index}
+    BPRINTF_FORCEINLINE BPRINTF_CONSTEXPR14 std::uint64_t parse_uint64_or_argument (
+        cstr_type &   begin
+      , cstr_type     end
+      , std::size_t & argument
+      ) noexcept
+    {
+      if (peek_token (begin, end, argument_prelude) == null_char)
+      {
+        return parse_uint64 (begin, end);
+      }
+
+      ++begin;
+      argument = parse_uint64 (begin, end);
+
+      if (peek_token (begin, end, argument_epilogue) != null_char)
+      {
+        ++begin;
+      }
+
+      return std::uint64_t ();
+    }
+
+    // Parses a placeholder, %index[(+|-)(width|{n})[u|w]][.(precision|{n})][:spec]%, into context
+    //  begin and end delimit the text between prelude and epilogue
+    //  TContext is formatter_context or static_formatter_context, both have the fields set here
+    template<typename TContext>
+    BPRINTF_FORCEINLINE BPRINTF_CONSTEXPR14 void parse_placeholder (
+        TContext &  context
+      , cstr_type   begin
+      , cstr_type   end
+      ) noexcept
+    {
+      context.index               = parse_uint64 (begin, end);
+      context.right_align         = false;
+      context.width               = 0;
+      context.unit                = width_unit::bytes;
+      context.precision           = no_precision;
+      context.width_argument      = no_argument;
+      context.precision_argument  = no_argument;
+      context.fill                = space_char;
+
+      auto plus_minus_token = peek_token (begin, end, plus_char, minus_char);
+
+      if (plus_minus_token != null_char)
+      {
+        ++begin;
+        context.right_align = plus_minus_token == plus_char;
+        context.width       = parse_uint64_or_argument (begin, end, context.width_argument);
+
+        switch (peek_token (begin, end, code_points_char, cells_char))
+        {
+        case code_points_char:
+          ++begin;
+          context.unit = width_unit::code_points;
+          break;
+        case cells_char:
+          ++begin;
+          context.unit = width_unit::cells;
+          break;
+        default:
+          break;
+        }
+      }
+
+      if (peek_token (begin, end, precision_char) != null_char)
+      {
+        auto digits = ++begin;
+        context.precision = parse_uint64_or_argument (begin, end, context.precision_argument);
+
+        // A precision without digits, %0.%, is no precision
+        if (begin == digits)
+        {
+          context.precision = no_precision;
+        }
+      }
+
+      // The custom format string after the colon, empty if none
+      context.format_begin  = peek_token (begin, end, colon_char) != null_char ? begin + 1 : end;
+      context.format_end    = end;
+    }
+
+    enum class scan_kind
+    {
+      end         ,
+      escape      ,
+      placeholder ,
+    };
+
+    // The literal text [current, literal_end) precedes what was found, scanning continues at next
+    struct scan_token
+    {
+      scan_kind   kind        ;
+      cstr_type   literal_end ;
+      cstr_type   next        ;
+    };
+
+    // Finds the next placeholder from context.current and parses it into context
+    //  An escaped prelude char ends the literal text so it includes one prelude char
+    template<typename TContext>
+    BPRINTF_FORCEINLINE BPRINTF_CONSTEXPR14 scan_token scan_placeholder (TContext & context) noexcept
+    {
+      auto current = context.current;
+
+      while (*current != null_char && *current != format_prelude)
+      {
+        ++current;
+      }
+
+      if (*current == null_char)
+      {
+        return scan_token { scan_kind::end, current, current };
+      }
+
+      auto prelude = current;
+
+      ++current;
+
+      if (*current == format_prelude)
+      {
+        return scan_token { scan_kind::escape, current, current + 1 };
+      }
+
+      auto format_begin = current;
+
+      while (*current != null_char && *current != format_epilogue)
+      {
+        ++current;
+      }
+
+      if (*current == null_char)
+      {
+        // Incomplete placeholder, the rest of the format string is literal text
+        return scan_token { scan_kind::end, current, current };
+      }
+
+      parse_placeholder (context, format_begin, current);
+
+      return scan_token { scan_kind::placeholder, prelude, current + 1 };
+    }
+
+    // Width and precision taken from an argument, TContext has the fields of placeholder_spec
+    template<typename TContext, typename ...TArgs>
+    BPRINTF_CONSTEXPR14 void resolve_arguments (
+        TContext &          context
+      , TArgs const &       ...args
+      ) noexcept
+    {
+      if (context.width_argument != no_argument)
+      {
+        context.width     = find_argument_value (context.width_argument, args...);
+      }
+
+      if (context.precision_argument != no_argument)
+      {
+        context.precision = find_argument_value (context.precision_argument, args...);
+      }
+    }
+
+    // Writes value backwards into buffer ending at begin, returns where the digits begin
+    template<std::uint64_t divisor>
+    BPRINTF_CONSTEXPR14 std::size_t format_digits (
+        char_type *     buffer
+      , std::size_t     begin
+      , std::uint64_t   value
+      ) noexcept
+    {
+      static_assert (divisor >= 8U  , "divisor must be greater or equal to 8");
+      static_assert (divisor <= 16U , "divisor must be lesser or equal to 16");
+
+      do
+      {
+        buffer[--begin] = "0123456789ABCDEF"[value % divisor];
+        value           = value / divisor;
+      } while (value != 0);
+
+      return begin;
+    }
+
+    // Pads buffer to width display units, shared by push_buffer () and static_push_buffer ()
+    //  TTarget appends with append (begin, end) and append (count, fill)
+    template<typename TTarget>
+    BPRINTF_CONSTEXPR14 void push_padded (
+        TTarget &     target
+      , bool          right_align
+      , std::size_t   width
+      , std::size_t   display
+      , char_type     fill
+      , cstr_type     buffer
+      , std::size_t   size
+      )
+    {
+      if (width <= display)
+      {
+        target.append (buffer, buffer + size);
+      }
+      else if (right_align)
+      {
+        target.append (width - display, fill);
+        target.append (buffer, buffer + size);
+      }
+      else
+      {
+        target.append (buffer, buffer + size);
+        target.append (width - display, fill);
+      }
+    }
+
+    // Appends to chars, streaming calls flush whenever chars reaches the flush threshold
+    BPRINTF_FORCEINLINE void append_chars (
         formatter_context const & context
-      , cstr_type                 buffer
+      , cstr_type                 begin
       , std::size_t               size
       )
     {
-      BPRINTF_ASSERT (buffer);
+      auto & chars = context.chars;
 
-      auto & chars  = context.chars ;
-      auto width    = context.width ;
-      auto fill     = context.fill  ;
-      auto fsz      = width - size  ;
-
-      if (width <= size)
+      if (chars.size () + size < context.flush_threshold)
       {
-        chars.insert (chars.end (), buffer, buffer + size);
+        chars.insert (chars.end (), begin, begin + size);
       }
-      else if (context.right_align)
+      else
       {
-        chars.insert (chars.end (), fsz, fill);
-        chars.insert (chars.end (), buffer, buffer + size);
+        append_chars_streaming (context, begin, size);
+      }
+    }
+
+    BPRINTF_FORCEINLINE void append_fill (
+        formatter_context const & context
+      , std::size_t               count
+      , char_type                 fill
+      )
+    {
+      auto & chars = context.chars;
+
+      if (chars.size () + count < context.flush_threshold)
+      {
+        chars.insert (chars.end (), count, fill);
       }
       else
       {
-        chars.insert (chars.end (), buffer, buffer + size);
-        chars.insert (chars.end (), fsz, fill);
+        append_fill_streaming (context, count, fill);
+      }
+    }
+
+    // Lets push_padded () append to a formatter_context
+    struct context_target
+    {
+      formatter_context const & context;
+
+      BPRINTF_FORCEINLINE void append (
+          cstr_type   begin
+        , cstr_type   end
+        )
+      {
+        append_chars (context, begin, static_cast<std::size_t> (end - begin));
+      }
+
+      BPRINTF_FORCEINLINE void append (
+          std::size_t count
+        , char_type   fill
+        )
+      {
+        append_fill (context, count, fill);
+      }
+    };
+
+    BPRINTF_FORCEINLINE void push_buffer (
+        formatter_context const & context
+      , cstr_type                 buffer
+      , std::size_t               size
+      )
+    {
+      BPRINTF_ASSERT (buffer);
+
+      auto width    = context.width ;
+      auto fill     = context.fill  ;
+      auto display  = width > 0 && context.unit != width_unit::bytes
+        ? display_width (context.unit, buffer, size)
+        : size
+        ;
+
+      context_target target { context };
+
+      push_padded (target, context.right_align, width, display, fill, buffer, size);
+    }
+
+    // Precision truncates strings to at most precision units of the width, bytes unless the
+    //  width has a u or w suffix, without splitting a UTF-8 sequence
+    BPRINTF_FORCEINLINE void push_string (
+        formatter_context const & context
+      , cstr_type                 buffer
+      , std::size_t               size
+      )
+    {
+      if (size > context.precision)
+      {
+        size = utf8_prefix (context.unit, buffer, size, context.precision);
       }
+
+      push_buffer (context, buffer, size);
     }
 
     inline void push_cstr (
@@ -116,20 +455,20 @@ namespace better_printf
 
       auto size = std::strlen (cstr);
 
-      push_buffer (context, cstr, size);
+      push_string (context, cstr, size);
     }
 
-    void format__int64 (
+    BPRINTF_INLINE void format__int64 (
         formatter_context const & context
       , std::int64_t              value
       );
 
-    void format__uint64 (
+    BPRINTF_INLINE void format__uint64 (
         formatter_context const & context
       , std::uint64_t             value
       );
 
-    void format__double (
+    BPRINTF_INLINE void format__double (
         formatter_context const & context
       , double                    value
       );
@@ -164,12 +503,37 @@ namespace better_printf
       details::format__double (context, value);
     }
 
-    void format (
+    // Enums registered with BPRINTF_ENUM format as their name, others as their value
+    //  An integer spec, d, x, X or o, formats the value of registered enums too
+    template<typename TEnum>
+    details::enable_if_enum_t<TEnum> format (
+        details::formatter_context const &  context
+      , TEnum                               value
+      )
+    {
+      auto token  = details::peek_token (context.format_begin, context.format_end, 'd', 'x', 'X', 'o');
+
+      auto name   = token == details::null_char
+        ? details::find_enum_name (value)
+        : nullptr
+        ;
+
+      if (name)
+      {
+        details::push_string (context, name->name, name->size);
+      }
+      else
+      {
+        format (context, static_cast<std::underlying_type_t<TEnum>> (value));
+      }
+    }
+
+    BPRINTF_INLINE void format (
         details::formatter_context const &  context
       , cstr_type                           value
       );
 
-    void format (
+    BPRINTF_INLINE void format (
         details::formatter_context const &  context
       , std::string const &                 value
       );
@@ -0,0 +1,271 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_LOG__HPP
+#define BPRINTF_LOG__HPP
+
+#include "bprintf.hpp"
+
+#include <atomic>
+#include <chrono>
+
+// Logging front end on top of bsprintf:
+//
+//    BPRINTF_LOG (info, "Connected to %0%:%1%", host, port);
+//    BPRINTF_LOG_EVERY_N (debug, 100, "Queue depth %0%", depth);
+//    BPRINTF_LOG_RATE_LIMITED (warning, 10, 20, "Dropped packet from %0%", peer);
+//
+// Arguments of suppressed statements aren't evaluated.
+//  - Levels below BPRINTF_LOG_MIN_LEVEL are removed at compile time
+//  - Levels below set_log_level () cost one relaxed atomic load
+//  - EVERY_N logs 1 in n calls (every call for n < 1), RATE_LIMITED uses a token bucket
+//    (per_second, burst), both keep their state in a static per call site
+
+// 0 trace, 1 debug, 2 info, 3 warning, 4 error, 5 fatal, 6 off
+#ifndef BPRINTF_LOG_MIN_LEVEL
+# define BPRINTF_LOG_MIN_LEVEL 0
+#endif
+
+namespace better_printf
+{
+  enum class log_level : int
+  {
+    trace   = 0 ,
+    debug   = 1 ,
+    info    = 2 ,
+    warning = 3 ,
+    error   = 4 ,
+    fatal   = 5 ,
+    off     = 6 ,
+  };
+
+  namespace details
+  {
+    inline std::atomic<log_level> & runtime_log_level () noexcept
+    {
+      static std::atomic<log_level> level {log_level::info};
+      return level;
+    }
+
+    inline cstr_type log_level_name (log_level level) noexcept
+    {
+      switch (level)
+      {
+      case log_level::trace:
+        return "TRACE";
+      case log_level::debug:
+        return "DEBUG";
+      case log_level::info:
+        return "INFO";
+      case log_level::warning:
+        return "WARNING";
+      case log_level::error:
+        return "ERROR";
+      case log_level::fatal:
+        return "FATAL";
+      case log_level::off:
+      default:
+        return "OFF";
+      }
+    }
+
+    // n of BPRINTF_LOG_EVERY_N, values below 1 log every call
+    template<typename TPeriod>
+    constexpr std::uint64_t log_period (TPeriod n) noexcept
+    {
+      return n > 1 ? static_cast<std::uint64_t> (n) : 1U;
+    }
+
+    // Per call site state of BPRINTF_LOG_RATE_LIMITED, constant initialized so the
+    //  static needs no guard
+    class token_bucket
+    {
+    public:
+      constexpr token_bucket () noexcept
+        : tokens      (0)
+        , last_refill (0)
+      {
+      }
+
+      token_bucket (token_bucket const &)             = delete;
+      token_bucket (token_bucket &&)                  = delete;
+
+      token_bucket & operator= (token_bucket const &) = delete;
+      token_bucket & operator= (token_bucket &&)      = delete;
+
+      bool try_acquire (
+          std::int64_t  per_second
+        , std::int64_t  burst
+        ) noexcept
+      {
+        if (try_take ())
+        {
+          return true;
+        }
+
+        // Out of tokens, the clock is only read on this path
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds> (
+            std::chrono::steady_clock::now ().time_since_epoch ()
+          ).count ();
+
+        return try_refill (per_second, burst, now);
+      }
+
+      bool try_take () noexcept
+      {
+        auto available = tokens.load (std::memory_order_relaxed);
+
+        while (available > 0)
+        {
+          if (tokens.compare_exchange_weak (available, available - 1, std::memory_order_relaxed))
+          {
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+      // Refills the bucket as of now (nanoseconds, never 0) and takes one of the new tokens
+      bool try_refill (
+          std::int64_t  per_second
+        , std::int64_t  burst
+        , std::int64_t  now
+        ) noexcept
+      {
+        BPRINTF_ASSERT (per_second > 0);
+        BPRINTF_ASSERT (burst > 0);
+        BPRINTF_ASSERT (now != 0);
+
+        auto last     = last_refill.load (std::memory_order_relaxed);
+        auto interval = 1000000000LL / per_second;
+        interval      = interval > 0 ? interval : 1;
+
+        if (last != 0 && now - last < interval)
+        {
+          return false;
+        }
+
+        auto intervals  = last == 0 ? burst : (now - last) / interval;
+        auto refill     = intervals < burst ? intervals : burst;
+
+        // Advance by whole intervals so the elapsed part of the current one isn't lost,
+        //  a full bucket has nothing to carry over
+        auto next       = intervals < burst ? last + intervals * interval : now;
+
+        if (!last_refill.compare_exchange_strong (last, next, std::memory_order_relaxed))
+        {
+          // Another thread refilled the bucket
+          return false;
+        }
+
+        // Take one of the new tokens for this call
+        tokens.fetch_add (refill - 1, std::memory_order_relaxed);
+
+        return true;
+      }
+
+    private:
+      std::atomic<std::int64_t> tokens      ;
+      std::atomic<std::int64_t> last_refill ;
+    };
+
+    template<typename ...TArgs>
+    void write_log (
+        log_level   level
+      , cstr_type   format
+      , TArgs &&    ...args
+      )
+    {
+      auto & chars = get_thread_local_chars ();
+
+      // Only the message is recorded, the prefix is formatted past the recorder
+      format_chars (chars, "[%0%] ", log_level_name (level));
+      bsprintf (chars, format, std::forward<TArgs> (args)...);
+
+      chars.push_back (newline_char);
+
+      write_to_cout (chars);
+    }
+  }
+
+  inline void set_log_level (log_level level) noexcept
+  {
+    details::runtime_log_level ().store (level, std::memory_order_relaxed);
+  }
+
+  inline log_level get_log_level () noexcept
+  {
+    return details::runtime_log_level ().load (std::memory_order_relaxed);
+  }
+
+  inline bool is_log_enabled (log_level level) noexcept
+  {
+    return static_cast<int> (level) >= static_cast<int> (get_log_level ());
+  }
+}
+
+#define BPRINTF_LOG_IS_ENABLED(level)                                                     \
+  (   static_cast<int> (::better_printf::log_level::level) >= BPRINTF_LOG_MIN_LEVEL       \
+  &&  ::better_printf::is_log_enabled (::better_printf::log_level::level)                 \
+  )
+
+#define BPRINTF_LOG(level, ...)                                                           \
+  do                                                                                      \
+  {                                                                                       \
+    if (BPRINTF_LOG_IS_ENABLED (level))                                                   \
+    {                                                                                     \
+      ::better_printf::details::write_log (                                               \
+          ::better_printf::log_level::level                                               \
+        , __VA_ARGS__                                                                     \
+        );                                                                                \
+    }                                                                                     \
+  } while (false)
+
+#define BPRINTF_LOG_EVERY_N(level, n, ...)                                                \
+  do                                                                                      \
+  {                                                                                       \
+    if (BPRINTF_LOG_IS_ENABLED (level))                                                   \
+    {                                                                                     \
+      static std::atomic<std::uint64_t> bprintf_log_calls {0};                            \
+      if (bprintf_log_calls.fetch_add (1, std::memory_order_relaxed)                      \
+        % ::better_printf::details::log_period (n) == 0)                                  \
+      {                                                                                   \
+        ::better_printf::details::write_log (                                             \
+            ::better_printf::log_level::level                                             \
+          , __VA_ARGS__                                                                   \
+          );                                                                              \
+      }                                                                                   \
+    }                                                                                     \
+  } while (false)
+
+#define BPRINTF_LOG_RATE_LIMITED(level, per_second, burst, ...)                           \
+  do                                                                                      \
+  {                                                                                       \
+    if (BPRINTF_LOG_IS_ENABLED (level))                                                   \
+    {                                                                                     \
+      static ::better_printf::details::token_bucket bprintf_log_bucket;                   \
+      if (bprintf_log_bucket.try_acquire ((per_second), (burst)))                         \
+      {                                                                                   \
+        ::better_printf::details::write_log (                                             \
+            ::better_printf::log_level::level                                             \
+          , __VA_ARGS__                                                                   \
+          );                                                                              \
+      }                                                                                   \
+    }                                                                                     \
+  } while (false)
+
+#endif // BPRINTF_LOG__HPP
@@ -0,0 +1,166 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_HEADER_ONLY
+# include "stdafx.h"
+#endif
+
+#include "parallel.hpp"
+
+namespace better_printf
+{
+  namespace details
+  {
+    BPRINTF_INLINE format_pool::format_pool (std::size_t worker_count)
+      : stopping  (false)
+    {
+      workers.reserve (worker_count);
+
+      for (auto iter = 0U; iter < worker_count; ++iter)
+      {
+        workers.emplace_back ([this] () { run (); });
+      }
+    }
+
+    BPRINTF_INLINE format_pool::~format_pool () noexcept
+    {
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        stopping = true;
+      }
+
+      queued.notify_all ();
+
+      for (auto & worker : workers)
+      {
+        worker.join ();
+      }
+    }
+
+    BPRINTF_INLINE std::size_t format_pool::worker_count () const noexcept
+    {
+      return workers.size ();
+    }
+
+    BPRINTF_INLINE format_slot & format_pool::acquire ()
+    {
+      std::lock_guard<std::mutex> lock (mutex);
+
+      if (free_slots.empty ())
+      {
+        std::unique_ptr<format_slot> slot (new format_slot ());
+        slot->done = true;
+        slot->chars.reserve (initial_buffer);
+
+        // Reserved first so that returning the slot in release can't throw
+        free_slots.reserve (slots.size () + 1);
+        slots.push_back (std::move (slot));
+
+        return *slots.back ();
+      }
+
+      auto slot = free_slots.back ();
+      free_slots.pop_back ();
+
+      return *slot;
+    }
+
+    BPRINTF_INLINE void format_pool::submit (format_slot & slot)
+    {
+      BPRINTF_ASSERT (slot.format);
+
+      slot.error = nullptr;
+      slot.chars.clear ();
+
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        pending.push_back (&slot);
+
+        // Only once queued, release mustn't wait for a slot no worker will pick up
+        slot.done = false;
+      }
+
+      queued.notify_one ();
+    }
+
+    BPRINTF_INLINE void format_pool::wait (format_slot & slot)
+    {
+      {
+        std::unique_lock<std::mutex> lock (mutex);
+        formatted.wait (lock, [&slot] () { return slot.done; });
+      }
+
+      if (slot.error)
+      {
+        std::rethrow_exception (slot.error);
+      }
+    }
+
+    BPRINTF_INLINE void format_pool::release (format_slot & slot) noexcept
+    {
+      std::unique_lock<std::mutex> lock (mutex);
+      formatted.wait (lock, [&slot] () { return slot.done; });
+
+      slot.error = nullptr;
+      free_slots.push_back (&slot);
+    }
+
+    BPRINTF_INLINE void format_pool::run () noexcept
+    {
+      for (;;)
+      {
+        format_slot * slot = nullptr;
+
+        {
+          std::unique_lock<std::mutex> lock (mutex);
+          queued.wait (lock, [this] () { return stopping || !pending.empty (); });
+
+          if (pending.empty ())
+          {
+            return;
+          }
+
+          slot = pending.front ();
+          pending.pop_front ();
+        }
+
+        try
+        {
+          slot->format (slot->state, slot->chars);
+        }
+        catch (...)
+        {
+          slot->error = std::current_exception ();
+        }
+
+        {
+          std::lock_guard<std::mutex> lock (mutex);
+          slot->done = true;
+        }
+
+        // Several callers may be waiting on different slots
+        formatted.notify_all ();
+      }
+    }
+
+    BPRINTF_INLINE format_pool & get_format_pool ()
+    {
+      static format_pool pool (std::max (2U, std::thread::hardware_concurrency ()) - 1U);
+
+      return pool;
+    }
+  }
+}
@@ -0,0 +1,315 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_PARALLEL__HPP
+#define BPRINTF_PARALLEL__HPP
+
+#include "bprintf.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace better_printf
+{
+  namespace details
+  {
+    // Ranges smaller than this per worker are formatted on the calling thread
+    //  Rationale: handing a chunk to a worker costs more than formatting a few hundred records
+    constexpr std::size_t const min_parallel_chunk = 4096;
+
+    // A chunk of records handed to a pool worker
+    //  The pool keeps slots and their buffers between calls so steady state formatting doesn't allocate
+    struct format_slot
+    {
+      using format_type = void (*) (void const * state, chars_type & chars);
+
+      format_type         format  ;
+      void const *        state   ;
+      bool                done    ;
+      std::exception_ptr  error   ;
+      chars_type          chars   ;
+    };
+
+    // Persistent worker threads shared by all parallel calls, see get_format_pool ()
+    class format_pool
+    {
+    public:
+      BPRINTF_INLINE explicit format_pool (std::size_t worker_count);
+
+      BPRINTF_INLINE ~format_pool () noexcept;
+
+      format_pool (format_pool const &)             = delete;
+      format_pool (format_pool &&)                  = delete;
+
+      format_pool & operator= (format_pool const &) = delete;
+      format_pool & operator= (format_pool &&)      = delete;
+
+      BPRINTF_INLINE std::size_t worker_count () const noexcept;
+
+      // Takes a free slot, its buffer keeps the capacity it grew to in earlier calls
+      BPRINTF_INLINE format_slot & acquire ();
+
+      // Queues slot, a worker calls slot.format (slot.state, slot.chars)
+      BPRINTF_INLINE void submit (format_slot & slot);
+
+      // Waits until a worker has formatted slot, rethrows what the formatter threw
+      BPRINTF_INLINE void wait (format_slot & slot);
+
+      // Returns a submitted slot to the pool, waits for it first if needed
+      BPRINTF_INLINE void release (format_slot & slot) noexcept;
+
+    private:
+      BPRINTF_INLINE void run () noexcept;
+
+      std::mutex                                mutex       ;
+      std::condition_variable                   queued      ;
+      std::condition_variable                   formatted   ;
+      bool                                      stopping    ;
+      std::deque<format_slot *>                 pending     ;
+      std::vector<std::unique_ptr<format_slot>> slots       ;
+      std::vector<format_slot *>                free_slots  ;
+      std::vector<std::thread>                  workers     ;
+    };
+
+    // Function local so that header-only builds share one pool across translation units
+    //  The workers are started on first use, one per hardware thread besides the caller
+    BPRINTF_INLINE format_pool & get_format_pool ();
+
+    template<typename TIterator, typename TFormatter>
+    void format_range (
+        chars_type &  chars
+      , TIterator     begin
+      , TIterator     end
+      , TFormatter &  formatter
+      )
+    {
+      for (; begin != end; ++begin)
+      {
+        formatter (chars, *begin);
+      }
+    }
+
+    template<typename TIterator, typename TFormatter>
+    struct range_state
+    {
+      TFormatter *  formatter ;
+      TIterator     begin     ;
+      TIterator     end       ;
+
+      static void format (void const * state, chars_type & chars)
+      {
+        auto range = static_cast<range_state const *> (state);
+        format_range (chars, range->begin, range->end, *range->formatter);
+      }
+    };
+
+    // Splits [begin, end) into chunks, all but the first are queued on the pool
+    //  The caller formats the first chunk itself and then visits the queued chunks in order
+    template<typename TIterator, typename TFormatter>
+    class parallel_format
+    {
+    public:
+      parallel_format (
+          TIterator     begin
+        , TIterator     end
+        , TFormatter &  formatter
+        , std::size_t   concurrency
+        )
+        : pool      (get_format_pool ())
+        , first_end (end)
+        , first     (nullptr)
+      {
+        auto size = static_cast<std::size_t> (std::distance (begin, end));
+
+        if (concurrency == 0)
+        {
+          concurrency = pool.worker_count () + 1;
+        }
+
+        auto chunk_count  = std::min (concurrency, (size + min_parallel_chunk - 1) / min_parallel_chunk);
+
+        if (chunk_count <= 1)
+        {
+          return;
+        }
+
+        auto chunk_size   = size / chunk_count;
+        auto remainder    = size % chunk_count;
+
+        // The first chunk gets any remainder, the workers get equally sized chunks
+        first_end         = std::next (begin, chunk_size + remainder);
+        auto chunk_begin  = first_end;
+
+        // Reserved up front, slots point into ranges
+        ranges.reserve (chunk_count - 1);
+        chunks.reserve (chunk_count - 1);
+
+        try
+        {
+          for (auto iter = 1U; iter < chunk_count; ++iter)
+          {
+            auto chunk_end = std::next (chunk_begin, chunk_size);
+
+            ranges.push_back (range_state<TIterator, TFormatter> { &formatter, chunk_begin, chunk_end });
+
+            auto & slot = pool.acquire ();
+            slot.format = &range_state<TIterator, TFormatter>::format;
+            slot.state  = &ranges.back ();
+
+            chunks.push_back (&slot);
+            pool.submit (slot);
+
+            chunk_begin = chunk_end;
+          }
+        }
+        catch (...)
+        {
+          release_chunks ();
+          throw;
+        }
+      }
+
+      // Also reached when a formatter throws, workers may still reference formatter and ranges
+      ~parallel_format () noexcept
+      {
+        release_chunks ();
+      }
+
+      parallel_format (parallel_format const &)             = delete;
+      parallel_format (parallel_format &&)                  = delete;
+
+      parallel_format & operator= (parallel_format const &) = delete;
+      parallel_format & operator= (parallel_format &&)      = delete;
+
+      TIterator first_chunk_end () const noexcept
+      {
+        return first_end;
+      }
+
+      // Formats the first chunk on the calling thread into a pool slot, not the thread-local
+      //  buffer that a bprintf call from formatter or a sink would clear
+      chars_type const & format_first_chunk (
+          TIterator     begin
+        , TFormatter &  formatter
+        )
+      {
+        BPRINTF_ASSERT (!first);
+
+        first = &pool.acquire ();
+        first->chars.clear ();
+
+        format_range (first->chars, begin, first_end, formatter);
+
+        return first->chars;
+      }
+
+      // Calls visit (chars_type const &) for each queued chunk in order as soon as it's formatted
+      template<typename TVisit>
+      void visit_chunks (TVisit && visit)
+      {
+        for (auto chunk : chunks)
+        {
+          pool.wait (*chunk);
+          visit (static_cast<chars_type const &> (chunk->chars));
+        }
+      }
+
+    private:
+      void release_chunks () noexcept
+      {
+        if (first)
+        {
+          pool.release (*first);
+          first = nullptr;
+        }
+
+        for (auto chunk : chunks)
+        {
+          pool.release (*chunk);
+        }
+
+        chunks.clear ();
+      }
+
+      format_pool &                                     pool      ;
+      TIterator                                         first_end ;
+      format_slot *                                     first     ;
+      std::vector<range_state<TIterator, TFormatter>>   ranges    ;
+      std::vector<format_slot *>                        chunks    ;
+    };
+  }
+
+  // Formats the records in [begin, end) on a persistent pool of worker threads and appends
+  //  the result to chars in the original order. formatter (chars_type &, record) is called
+  //  concurrently and so must be thread-safe, typically it's a lambda calling bsprintf.
+  //  It mustn't call bsprintf_parallel or bfprintf_parallel, a worker waiting on the shared pool
+  //  deadlocks when every worker does, with one hardware thread the pool has a single worker.
+  //  concurrency caps the number of chunks, 0 means one per pool worker plus the calling thread.
+  template<typename TIterator, typename TFormatter>
+  void bsprintf_parallel (
+      chars_type &  chars
+    , TIterator     begin
+    , TIterator     end
+    , TFormatter && formatter
+    , std::size_t   concurrency = 0
+    )
+  {
+    details::parallel_format<TIterator, typename std::remove_reference<TFormatter>::type> parallel (begin, end, formatter, concurrency);
+
+    details::format_range (chars, begin, parallel.first_chunk_end (), formatter);
+
+    parallel.visit_chunks ([&chars] (chars_type const & formatted)
+      {
+        chars.insert (chars.end (), formatted.begin (), formatted.end ());
+      });
+  }
+
+  // Like bsprintf_parallel but streams each chunk to sink in the original order as soon as
+  //  it and all preceding chunks are formatted, the chunks aren't copied. formatter and
+  //  sink.write may call bprintf on the calling thread.
+  template<typename TSink, typename TIterator, typename TFormatter>
+  void bfprintf_parallel (
+      TSink &       sink
+    , TIterator     begin
+    , TIterator     end
+    , TFormatter && formatter
+    , std::size_t   concurrency = 0
+    )
+  {
+    details::parallel_format<TIterator, typename std::remove_reference<TFormatter>::type> parallel (begin, end, formatter, concurrency);
+
+    sink.write (parallel.format_first_chunk (begin, formatter));
+
+    parallel.visit_chunks ([&sink] (chars_type const & formatted)
+      {
+        sink.write (formatted);
+      });
+  }
+}
+
+#ifdef BPRINTF_HEADER_ONLY
+# include "parallel.cpp"
+#endif
+
+#endif // BPRINTF_PARALLEL__HPP
@@ -0,0 +1,286 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_HEADER_ONLY
+# include "stdafx.h"
+#endif
+
+#include "bprintf.hpp"
+#include "recorder.hpp"
+
+#include <cstdio>
+#include <mutex>
+
+namespace better_printf
+{
+  namespace details
+  {
+    struct recorder_state
+    {
+      std::mutex    mutex ;
+      std::FILE *   file  ;
+    };
+
+    BPRINTF_INLINE recorder_state & get_recorder_state ()
+    {
+      static recorder_state state {};
+      return state;
+    }
+
+    BPRINTF_INLINE chars_type & get_thread_local_trace_chars ()
+    {
+      thread_local chars_type trace_chars = create_chars ();
+
+      trace_chars.clear ();
+
+      return trace_chars;
+    }
+
+    BPRINTF_INLINE void write_trace_record (chars_type const & chars)
+    {
+      auto & state = get_recorder_state ();
+
+      std::lock_guard<std::mutex> lock (state.mutex);
+
+      if (state.file && !chars.empty ())
+      {
+        auto written_objects = std::fwrite (&chars.front (), sizeof (char_type), chars.size (), state.file);
+        BPRINTF_ASSERT (written_objects == chars.size ());
+      }
+    }
+
+    // Recorded arguments as one argument of resolve_arguments () and apply_formatter (),
+    //  so a record replays through the same path as the bsprintf call it came from
+    struct trace_argument_view
+    {
+      std::vector<trace_argument> const & arguments;
+    };
+
+    BPRINTF_INLINE std::size_t find_argument_value (
+        std::size_t                   index
+      , trace_argument_view const &   view
+      ) noexcept
+    {
+      if (index >= view.arguments.size ())
+      {
+        return 0U;
+      }
+
+      auto & argument = view.arguments[index];
+
+      switch (argument.kind)
+      {
+      case trace_kind::int64:
+        return argument_value (argument.int64);
+      case trace_kind::uint64:
+        return argument_value (argument.uint64);
+      default:
+        return 0U;
+      }
+    }
+
+    BPRINTF_INLINE void apply_formatter (
+        formatter_context &           context
+      , trace_argument_view const &   view
+      )
+    {
+      if (context.index >= view.arguments.size ())
+      {
+        apply_formatter (context);
+        return;
+      }
+
+      auto & argument = view.arguments[context.index];
+
+      switch (argument.kind)
+      {
+      case trace_kind::int64:
+        format_argument (context, argument.int64);
+        break;
+      case trace_kind::uint64:
+        format_argument (context, argument.uint64);
+        break;
+      case trace_kind::real:
+        format_argument (context, argument.real);
+        break;
+      case trace_kind::string:
+      case trace_kind::custom:
+        format_argument (context, argument.string);
+        break;
+      }
+    }
+
+    template<typename TValue>
+    bool read_trace_value (
+        std::FILE *   file
+      , TValue &      value
+      )
+    {
+      return std::fread (&value, sizeof (value), 1, file) == 1;
+    }
+
+    BPRINTF_INLINE bool read_trace_chars (
+        std::FILE *   file
+      , std::string & value
+      )
+    {
+      std::uint32_t size;
+      if (!read_trace_value (file, size))
+      {
+        return false;
+      }
+
+      value.resize (size);
+
+      return size == 0 || std::fread (&value.front (), sizeof (char_type), size, file) == size;
+    }
+  }
+
+  BPRINTF_INLINE bool start_recording (
+      cstr_type     path
+    , std::size_t   sample_every
+    )
+  {
+    BPRINTF_ASSERT (path);
+
+    stop_recording ();
+
+    auto & state = details::get_recorder_state ();
+
+    {
+      std::lock_guard<std::mutex> lock (state.mutex);
+
+      state.file = std::fopen (path, "wb");
+      if (!state.file)
+      {
+        return false;
+      }
+
+      std::fwrite (details::trace_magic, sizeof (char_type), 4, state.file);
+      std::fwrite (&details::trace_version, sizeof (details::trace_version), 1, state.file);
+    }
+
+    details::recorder_sample_every ().store (sample_every > 0 ? sample_every : 1);
+
+    return true;
+  }
+
+  BPRINTF_INLINE void stop_recording ()
+  {
+    details::recorder_sample_every ().store (0);
+
+    auto & state = details::get_recorder_state ();
+
+    std::lock_guard<std::mutex> lock (state.mutex);
+
+    if (state.file)
+    {
+      std::fclose (state.file);
+      state.file = nullptr;
+    }
+  }
+
+  BPRINTF_INLINE bool load_trace (
+      cstr_type                   path
+    , std::vector<trace_record> & records
+    )
+  {
+    BPRINTF_ASSERT (path);
+
+    auto file = std::fopen (path, "rb");
+    if (!file)
+    {
+      return false;
+    }
+
+    char_type     magic [4] {};
+    std::uint32_t version   {};
+
+    auto result =
+          std::fread (magic, sizeof (char_type), 4, file) == 4
+      &&  std::memcmp (magic, details::trace_magic, 4) == 0
+      &&  details::read_trace_value (file, version)
+      &&  version == details::trace_version
+      ;
+
+    while (result)
+    {
+      trace_record record;
+
+      if (!details::read_trace_chars (file, record.format))
+      {
+        // End of trace
+        break;
+      }
+
+      std::uint8_t argument_count;
+      result = details::read_trace_value (file, argument_count);
+
+      for (auto iter = 0U; result && iter < argument_count; ++iter)
+      {
+        trace_argument argument {};
+
+        result = details::read_trace_value (file, argument.kind);
+
+        switch (argument.kind)
+        {
+        case trace_kind::int64:
+          result = result && details::read_trace_value (file, argument.int64);
+          break;
+        case trace_kind::uint64:
+          result = result && details::read_trace_value (file, argument.uint64);
+          break;
+        case trace_kind::real:
+          result = result && details::read_trace_value (file, argument.real);
+          break;
+        case trace_kind::string:
+        case trace_kind::custom:
+          result = result && details::read_trace_chars (file, argument.string);
+          break;
+        default:
+          result = false;
+          break;
+        }
+
+        record.arguments.push_back (std::move (argument));
+      }
+
+      if (result)
+      {
+        records.push_back (std::move (record));
+      }
+    }
+
+    std::fclose (file);
+
+    return result;
+  }
+
+  BPRINTF_INLINE void replay_record (
+      chars_type &          chars
+    , trace_record const &  record
+    )
+  {
+    details::formatter_context    context   (chars, record.format.c_str ());
+    details::trace_argument_view  arguments {record.arguments};
+
+    while (details::scan (context))
+    {
+      details::resolve_arguments (context, arguments);
+      details::apply_formatter (context, arguments);
+    }
+  }
+}
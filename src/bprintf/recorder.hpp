@@ -0,0 +1,256 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_RECORDER__HPP
+#define BPRINTF_RECORDER__HPP
+
+#include "core.hpp"
+#include "formatters.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Define BPRINTF_ENABLE_RECORDER to let bsprintf sample its calls into a trace file
+//  once start_recording has been called. Without it bsprintf has no recorder overhead.
+//
+// Trace file layout (native byte order):
+//  header    : "BPRT" u32 version
+//  record    : u32 format size, format chars, u8 argument count, arguments
+//  argument  : u8 trace_kind, payload
+//    int64, uint64, double : 8 bytes
+//    string, custom        : u32 size, chars (custom holds the argument formatted without spec)
+
+namespace better_printf
+{
+  enum class trace_kind : std::uint8_t
+  {
+    int64   = 0 ,
+    uint64  = 1 ,
+    real    = 2 ,
+    string  = 3 ,
+    custom  = 4 ,
+  };
+
+  struct trace_argument
+  {
+    trace_kind    kind    ;
+    std::int64_t  int64   ;
+    std::uint64_t uint64  ;
+    double        real    ;
+    std::string   string  ;
+  };
+
+  struct trace_record
+  {
+    std::string                 format    ;
+    std::vector<trace_argument> arguments ;
+  };
+
+  // Starts sampling 1 in sample_every bsprintf calls into the trace file at path
+  BPRINTF_INLINE bool start_recording (
+      cstr_type     path
+    , std::size_t   sample_every
+    );
+
+  BPRINTF_INLINE void stop_recording ();
+
+  BPRINTF_INLINE bool load_trace (
+      cstr_type                   path
+    , std::vector<trace_record> & records
+    );
+
+  // Formats a recorded call the same way bsprintf formatted the original call
+  BPRINTF_INLINE void replay_record (
+      chars_type &          chars
+    , trace_record const &  record
+    );
+
+  namespace details
+  {
+    constexpr char_type const     trace_magic []  = "BPRT"  ;
+    constexpr std::uint32_t const trace_version   = 1       ;
+
+    inline std::atomic<std::size_t> & recorder_sample_every () noexcept
+    {
+      static std::atomic<std::size_t> sample_every {0};
+      return sample_every;
+    }
+
+    inline bool should_record () noexcept
+    {
+      auto sample_every = recorder_sample_every ().load (std::memory_order_relaxed);
+      if (sample_every == 0)
+      {
+        return false;
+      }
+
+      thread_local std::size_t countdown = 0;
+
+      if (countdown == 0)
+      {
+        countdown = sample_every - 1;
+        return true;
+      }
+
+      --countdown;
+      return false;
+    }
+
+    BPRINTF_INLINE chars_type & get_thread_local_trace_chars ();
+
+    BPRINTF_INLINE void write_trace_record (chars_type const & chars);
+
+    template<typename TValue>
+    void push_trace_value (
+        chars_type &  chars
+      , TValue        value
+      )
+    {
+      auto bytes = reinterpret_cast<char_type const *> (&value);
+      chars.insert (chars.end (), bytes, bytes + sizeof (value));
+    }
+
+    inline void push_trace_chars (
+        chars_type &  chars
+      , cstr_type     value
+      , std::size_t   size
+      )
+    {
+      push_trace_value (chars, static_cast<std::uint32_t> (size));
+      chars.insert (chars.end (), value, value + size);
+    }
+
+    template<typename TValue>
+    using enable_if_custom_t            = std::enable_if_t<
+          !std::is_arithmetic<TValue>::value
+      &&  !std::is_convertible<TValue const &, cstr_type>::value
+      &&  !std::is_same<TValue, std::string>::value
+      >;
+
+    template<typename TIntegral>
+    enable_if_signed_integral_t<TIntegral> record_argument (
+        chars_type &  chars
+      , TIntegral     value
+      )
+    {
+      chars.push_back (static_cast<char_type> (trace_kind::int64));
+      push_trace_value (chars, static_cast<std::int64_t> (value));
+    }
+
+    template<typename TIntegral>
+    enable_if_unsigned_integral_t<TIntegral> record_argument (
+        chars_type &  chars
+      , TIntegral     value
+      )
+    {
+      chars.push_back (static_cast<char_type> (trace_kind::uint64));
+      push_trace_value (chars, static_cast<std::uint64_t> (value));
+    }
+
+    template<typename TFloat>
+    enable_if_floating_point_t<TFloat> record_argument (
+        chars_type &  chars
+      , TFloat        value
+      )
+    {
+      chars.push_back (static_cast<char_type> (trace_kind::real));
+      push_trace_value (chars, static_cast<double> (value));
+    }
+
+    inline void record_argument (
+        chars_type &  chars
+      , cstr_type     value
+      )
+    {
+      value = value ? value : "";
+      chars.push_back (static_cast<char_type> (trace_kind::string));
+      push_trace_chars (chars, value, std::strlen (value));
+    }
+
+    inline void record_argument (
+        chars_type &          chars
+      , std::string const &   value
+      )
+    {
+      chars.push_back (static_cast<char_type> (trace_kind::string));
+      push_trace_chars (chars, value.data (), value.size ());
+    }
+
+    template<typename TValue>
+    enable_if_custom_t<TValue> record_argument (
+        chars_type &    chars
+      , TValue const &  value
+      )
+    {
+      // Custom types are recorded as their default formatted text
+      chars_type formatted;
+      {
+        formatter_context context (formatted, "");
+        formatters::format (context, value);
+      }
+
+      chars.push_back (static_cast<char_type> (trace_kind::custom));
+      push_trace_chars (chars, formatted.empty () ? "" : &formatted.front (), formatted.size ());
+    }
+
+    inline void record_arguments (chars_type &)
+    {
+    }
+
+    template<typename THead, typename ...TTail>
+    void record_arguments (
+        chars_type &        chars
+      , THead const &       head
+      , TTail const &       ...tail
+      )
+    {
+      record_argument (chars, head);
+      record_arguments (chars, tail...);
+    }
+
+    template<typename ...TArgs>
+    void record_call (
+        cstr_type           format
+      , TArgs const &       ...args
+      )
+    {
+      if (!should_record ())
+      {
+        return;
+      }
+
+      static_assert (sizeof... (args) < 256, "Too many arguments to record");
+
+      auto & chars = get_thread_local_trace_chars ();
+
+      format = format ? format : "";
+      push_trace_chars (chars, format, std::strlen (format));
+      chars.push_back (static_cast<char_type> (sizeof... (args)));
+
+      record_arguments (chars, args...);
+
+      write_trace_record (chars);
+    }
+  }
+}
+
+#ifdef BPRINTF_HEADER_ONLY
+# include "recorder.cpp"
+#endif
+
+#endif // BPRINTF_RECORDER__HPP
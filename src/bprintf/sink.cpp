@@ -0,0 +1,782 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_HEADER_ONLY
+# include "stdafx.h"
+#endif
+
+#include "sink.hpp"
+
+#ifdef BPRINTF_HAS_MMAP_SINK
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace better_printf
+{
+  namespace details
+  {
+    namespace impl
+    {
+      // Sizes fd to size with its blocks allocated
+      inline bool allocate_file (
+          int           fd
+        , std::size_t   size
+        ) noexcept
+      {
+#ifdef __APPLE__
+        fstore_t store {};
+
+        store.fst_flags   = F_ALLOCATEALL     ;
+        store.fst_posmode = F_PEOFPOSMODE     ;
+        store.fst_offset  = 0                 ;
+        store.fst_length  = static_cast<off_t> (size);
+
+        if (::fcntl (fd, F_PREALLOCATE, &store) == -1)
+        {
+          return false;
+        }
+
+        return ::ftruncate (fd, static_cast<off_t> (size)) == 0;
+#else
+        int result;
+
+        do
+        {
+          // Returns the error rather than setting errno
+          result = ::posix_fallocate (fd, 0, static_cast<off_t> (size));
+        } while (result == EINTR);
+
+        return result == 0;
+#endif
+      }
+    }
+  }
+
+  BPRINTF_INLINE mmap_file_sink::mmap_file_sink (
+      std::string   base_path
+    , std::size_t   size_limit
+    )
+    : base_path   (std::move (base_path))
+    , size_limit  (size_limit > 0 ? size_limit : details::initial_buffer)
+    , file_index  (0)
+    , current     (nullptr)
+    , writes      (0)
+    , roll_failed (false)
+  {
+    current.store (open_segment (this->size_limit));
+  }
+
+  BPRINTF_INLINE mmap_file_sink::~mmap_file_sink () noexcept
+  {
+    auto s = current.exchange (nullptr);
+    if (s)
+    {
+      close_segment (s);
+    }
+  }
+
+  BPRINTF_INLINE bool mmap_file_sink::is_open () const noexcept
+  {
+    return current.load () != nullptr && !roll_failed.load ();
+  }
+
+  BPRINTF_INLINE void mmap_file_sink::write (chars_type const & chars)
+  {
+    auto sz = chars.size ();
+    if (sz == 0)
+    {
+      return;
+    }
+
+    // Counted before current is loaded, roll () only reclaims closed segments when no write is in progress
+    ++writes;
+
+    for (;;)
+    {
+      auto s = current.load ();
+      if (!s)
+      {
+        // Failed to open the log file, drop the message
+        --writes;
+        return;
+      }
+
+      // Register as a writer before reserving, then make sure the segment wasn't rolled
+      //  Rationale: roll () publishes the next segment before it waits for writers to leave
+      ++s->writers;
+      if (current.load () != s)
+      {
+        --s->writers;
+        continue;
+      }
+
+      auto offset = s->reserved.fetch_add (sz, std::memory_order_relaxed);
+      if (offset + sz <= s->capacity)
+      {
+        std::memcpy (s->base + offset, &chars.front (), sz);
+        s->committed.fetch_add (sz, std::memory_order_relaxed);
+        --s->writers;
+        --writes;
+        return;
+      }
+
+      --s->writers;
+
+      auto rolled = false;
+
+      try
+      {
+        rolled = roll (s, sz);
+      }
+      catch (...)
+      {
+        --writes;
+        throw;
+      }
+
+      if (!rolled)
+      {
+        // Failed to open the next log file, drop the message
+        --writes;
+        return;
+      }
+    }
+  }
+
+  BPRINTF_INLINE mmap_file_sink::segment * mmap_file_sink::open_segment (std::size_t capacity)
+  {
+    auto path = base_path + "." + std::to_string (file_index);
+
+    // Reserved up front so that a mapped segment is never leaked
+    segments.reserve (segments.size () + 1);
+
+    auto fd = ::open (path.c_str (), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+      return nullptr;
+    }
+
+    // Allocates the blocks up front, a sparse file would raise SIGBUS on the first write
+    //  to a page once the disk is full
+    if (!details::impl::allocate_file (fd, capacity))
+    {
+      ::close (fd);
+      return nullptr;
+    }
+
+    auto flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    // Maps the pages up front, the first write to each page still faults to mark it dirty
+    flags |= MAP_POPULATE;
+#endif
+
+    auto base = ::mmap (nullptr, capacity, PROT_READ | PROT_WRITE, flags, fd, 0);
+    if (base == MAP_FAILED)
+    {
+      ::close (fd);
+      return nullptr;
+    }
+
+    std::unique_ptr<segment> s (new segment {});
+
+    s->fd       = fd                              ;
+    s->base     = static_cast<char_type *> (base) ;
+    s->capacity = capacity                        ;
+
+    // Only advanced on success so that a retried roll reuses the file name
+    ++file_index;
+
+    segments.push_back (std::move (s));
+
+    return segments.back ().get ();
+  }
+
+  BPRINTF_INLINE void mmap_file_sink::close_segment (segment * s) noexcept
+  {
+    BPRINTF_ASSERT (s);
+
+    // Successful reservations always form a prefix of the segment
+    //  so truncating to the committed size removes the unused tail
+    auto committed = s->committed.load ();
+
+    auto munmap_result = ::munmap (s->base, s->capacity);
+    BPRINTF_ASSERT (munmap_result == 0);
+
+    auto ftruncate_result = ::ftruncate (s->fd, static_cast<off_t> (committed));
+    BPRINTF_ASSERT (ftruncate_result == 0);
+
+    ::close (s->fd);
+
+    s->fd   = -1      ;
+    s->base = nullptr ;
+  }
+
+  BPRINTF_INLINE bool mmap_file_sink::roll (segment * full, std::size_t min_capacity)
+  {
+    std::lock_guard<std::mutex> lock (roll_mutex);
+
+    if (current.load () != full)
+    {
+      // Another writer already rolled the segment
+      return true;
+    }
+
+    auto next = open_segment (size_limit < min_capacity ? min_capacity : size_limit);
+    if (!next)
+    {
+      // Keep the full segment current so that writers never see nullptr, the next
+      //  message that doesn't fit retries the roll
+      roll_failed.store (true);
+      return false;
+    }
+
+    current.store (next);
+    roll_failed.store (false);
+
+    while (full->writers.load () != 0)
+    {
+      std::this_thread::yield ();
+    }
+
+    close_segment (full);
+
+    // The write that called roll () is still counted
+    reclaim_segments (1);
+
+    return true;
+  }
+
+  BPRINTF_INLINE void mmap_file_sink::reclaim_segments (std::size_t own_writes) noexcept
+  {
+    // A write holding a stale segment pointer incremented writes before it loaded current,
+    //  and so before the segment was replaced. Once no other write is in progress
+    //  only current can be loaded.
+    if (writes.load () > own_writes)
+    {
+      return;
+    }
+
+    auto live = current.load ();
+
+    segments.erase (
+        std::remove_if (
+            segments.begin ()
+          , segments.end ()
+          , [live] (std::unique_ptr<segment> const & s) { return s.get () != live; }
+          )
+      , segments.end ()
+      );
+  }
+}
+
+#endif // BPRINTF_HAS_MMAP_SINK
+
+#ifdef BPRINTF_HAS_IO_URING_SINK
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace better_printf
+{
+  namespace details
+  {
+    namespace impl
+    {
+      // Raw syscalls, liburing isn't required
+      inline int io_uring_setup (
+          unsigned            entries
+        , io_uring_params *   params
+        ) noexcept
+      {
+        return static_cast<int> (::syscall (__NR_io_uring_setup, entries, params));
+      }
+
+      inline int io_uring_enter (
+          int       ring_fd
+        , unsigned  to_submit
+        , unsigned  min_complete
+        , unsigned  flags
+        ) noexcept
+      {
+        return static_cast<int> (::syscall (__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+      }
+
+      inline int io_uring_register (
+          int             ring_fd
+        , unsigned        opcode
+        , void const *    args
+        , unsigned        arg_count
+        ) noexcept
+      {
+        return static_cast<int> (::syscall (__NR_io_uring_register, ring_fd, opcode, args, arg_count));
+      }
+
+      template<typename T>
+      T * ring_pointer (
+          void *          ring
+        , std::uint32_t   offset
+        ) noexcept
+      {
+        return reinterpret_cast<T *> (static_cast<char *> (ring) + offset);
+      }
+
+      inline void * map_ring (
+          int           ring_fd
+        , std::size_t   size
+        , off_t         offset
+        ) noexcept
+      {
+        auto ring = ::mmap (nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+        return ring == MAP_FAILED ? nullptr : ring;
+      }
+    }
+  }
+
+  BPRINTF_INLINE io_uring_sink::io_uring_sink (
+      int           fd
+    , std::size_t   buffer_size
+    , std::size_t   buffer_count
+    , bool          use_io_uring
+    )
+    : fd            (fd)
+    , buffer_size   (buffer_size > 0 ? buffer_size : details::initial_buffer)
+    , positioned    (false)
+    , file_offset   (0)
+    , current       (0)
+    , in_flight     (0)
+    , ring_fd       (-1)
+    , sq_ring       (nullptr)
+    , sq_ring_size  (0)
+    , cq_ring       (nullptr)
+    , cq_ring_size  (0)
+    , sqes          (nullptr)
+    , sqes_size     (0)
+    , sq_head       (nullptr)
+    , sq_tail       (nullptr)
+    , sq_mask       (nullptr)
+    , sq_array      (nullptr)
+    , cq_head       (nullptr)
+    , cq_tail       (nullptr)
+    , cq_mask       (nullptr)
+    , cqes          (nullptr)
+  {
+    // At least two buffers so one can be filled while another is written
+    buffer_count = buffer_count > 2 ? buffer_count : 2;
+
+    memory.reset (new char_type [this->buffer_size * buffer_count]);
+
+    buffers.reserve (buffer_count);
+    free_buffers.reserve (buffer_count);
+
+    for (auto iter = 0U; iter < buffer_count; ++iter)
+    {
+      buffers.push_back (buffer { memory.get () + iter * this->buffer_size, 0, 0 });
+      if (iter > 0)
+      {
+        free_buffers.push_back (iter);
+      }
+    }
+
+    struct stat st {};
+    auto flags = ::fcntl (fd, F_GETFL);
+
+    if (::fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && flags != -1 && (flags & O_APPEND) == 0)
+    {
+      auto position = ::lseek (fd, 0, SEEK_CUR);
+      if (position >= 0)
+      {
+        positioned  = true;
+        file_offset = static_cast<std::uint64_t> (position);
+      }
+    }
+
+    if (use_io_uring && !setup_ring ())
+    {
+      teardown_ring ();
+    }
+  }
+
+  BPRINTF_INLINE io_uring_sink::~io_uring_sink () noexcept
+  {
+    flush ();
+    teardown_ring ();
+  }
+
+  BPRINTF_INLINE bool io_uring_sink::uses_io_uring () const noexcept
+  {
+    return ring_fd >= 0;
+  }
+
+  BPRINTF_INLINE void io_uring_sink::write (chars_type const & chars)
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+
+    auto data = chars.data ();
+    auto size = chars.size ();
+
+    while (size > 0)
+    {
+      auto & b = buffers[current];
+
+      auto n = std::min (size, buffer_size - b.size);
+
+      std::memcpy (b.data + b.size, data, n);
+
+      b.size  += n;
+      data    += n;
+      size    -= n;
+
+      if (b.size == buffer_size)
+      {
+        submit_current ();
+      }
+    }
+
+    if (in_flight > 0)
+    {
+      // Recycle completed buffers without a syscall
+      reap (false, no_buffer);
+    }
+  }
+
+  BPRINTF_INLINE void io_uring_sink::flush ()
+  {
+    std::lock_guard<std::mutex> lock (mutex);
+
+    submit_current ();
+
+    while (in_flight > 0)
+    {
+      reap (true, no_buffer);
+    }
+
+    // Writes at explicit offsets don't move the file position, later writes to fd would overwrite the log
+    if (positioned)
+    {
+      ::lseek (fd, static_cast<off_t> (file_offset), SEEK_SET);
+    }
+  }
+
+  BPRINTF_INLINE bool io_uring_sink::setup_ring ()
+  {
+    io_uring_params params {};
+
+    ring_fd = details::impl::io_uring_setup (static_cast<unsigned> (buffers.size ()), &params);
+    if (ring_fd < 0)
+    {
+      return false;
+    }
+
+    sq_ring_size  = params.sq_off.array + params.sq_entries * sizeof (unsigned);
+    cq_ring_size  = params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe);
+    sqes_size     = params.sq_entries * sizeof (io_uring_sqe);
+
+    auto single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+
+    if (single_mmap)
+    {
+      sq_ring_size = cq_ring_size = std::max (sq_ring_size, cq_ring_size);
+    }
+
+    sq_ring = details::impl::map_ring (ring_fd, sq_ring_size, IORING_OFF_SQ_RING);
+    cq_ring = single_mmap ? sq_ring : details::impl::map_ring (ring_fd, cq_ring_size, IORING_OFF_CQ_RING);
+    sqes    = details::impl::map_ring (ring_fd, sqes_size, IORING_OFF_SQES);
+
+    if (!sq_ring || !cq_ring || !sqes)
+    {
+      return false;
+    }
+
+    sq_head   = details::impl::ring_pointer<unsigned> (sq_ring, params.sq_off.head);
+    sq_tail   = details::impl::ring_pointer<unsigned> (sq_ring, params.sq_off.tail);
+    sq_mask   = details::impl::ring_pointer<unsigned> (sq_ring, params.sq_off.ring_mask);
+    sq_array  = details::impl::ring_pointer<unsigned> (sq_ring, params.sq_off.array);
+    cq_head   = details::impl::ring_pointer<unsigned> (cq_ring, params.cq_off.head);
+    cq_tail   = details::impl::ring_pointer<unsigned> (cq_ring, params.cq_off.tail);
+    cq_mask   = details::impl::ring_pointer<unsigned> (cq_ring, params.cq_off.ring_mask);
+    cqes      = details::impl::ring_pointer<void>     (cq_ring, params.cq_off.cqes);
+
+    std::vector<iovec> iovecs;
+    iovecs.reserve (buffers.size ());
+
+    for (auto & b : buffers)
+    {
+      iovecs.push_back (iovec { b.data, buffer_size });
+    }
+
+    return details::impl::io_uring_register (
+        ring_fd
+      , IORING_REGISTER_BUFFERS
+      , iovecs.data ()
+      , static_cast<unsigned> (iovecs.size ())
+      ) == 0;
+  }
+
+  BPRINTF_INLINE void io_uring_sink::teardown_ring () noexcept
+  {
+    if (sqes)
+    {
+      ::munmap (sqes, sqes_size);
+    }
+
+    if (cq_ring && cq_ring != sq_ring)
+    {
+      ::munmap (cq_ring, cq_ring_size);
+    }
+
+    if (sq_ring)
+    {
+      ::munmap (sq_ring, sq_ring_size);
+    }
+
+    if (ring_fd >= 0)
+    {
+      // Closing the ring also unregisters the buffers
+      ::close (ring_fd);
+    }
+
+    ring_fd   = -1      ;
+    sq_ring   = nullptr ;
+    cq_ring   = nullptr ;
+    sqes      = nullptr ;
+
+    // Pointers into the unmapped rings
+    sq_head   = nullptr ;
+    sq_tail   = nullptr ;
+    sq_mask   = nullptr ;
+    sq_array  = nullptr ;
+    cq_head   = nullptr ;
+    cq_tail   = nullptr ;
+    cq_mask   = nullptr ;
+    cqes      = nullptr ;
+  }
+
+  BPRINTF_INLINE void io_uring_sink::abandon_ring (std::size_t unsubmitted)
+  {
+    teardown_ring ();
+
+    // Other buffers that still hold data were in flight, writing them again is harmless
+    //  as positioned writes go to the same offset and unpositioned ones are only submitted when
+    //  nothing else is in flight
+    for (auto iter = 0U; iter < buffers.size (); ++iter)
+    {
+      auto & b = buffers[iter];
+
+      if (iter != unsubmitted && b.size > 0)
+      {
+        write_sync (b.data, b.size, b.offset);
+        b.size = 0;
+        free_buffers.push_back (iter);
+      }
+    }
+
+    in_flight = 0;
+  }
+
+  BPRINTF_INLINE void io_uring_sink::submit_current ()
+  {
+    auto & b = buffers[current];
+    if (b.size == 0)
+    {
+      return;
+    }
+
+    b.offset = file_offset;
+    if (positioned)
+    {
+      file_offset += b.size;
+    }
+
+    // Unpositioned writes complete in submission order only if one is in flight at a time
+    while (ring_fd >= 0 && !positioned && in_flight > 0)
+    {
+      reap (true, current);
+    }
+
+    if (ring_fd < 0)
+    {
+      // Fallback, write synchronously and reuse the buffer
+      write_sync (b.data, b.size, b.offset);
+      b.size = 0;
+      return;
+    }
+
+    auto tail   = *sq_tail;
+    auto index  = tail & *sq_mask;
+    auto sqe    = static_cast<io_uring_sqe *> (sqes) + index;
+
+    std::memset (sqe, 0, sizeof (io_uring_sqe));
+
+    sqe->opcode     = IORING_OP_WRITE_FIXED                     ;
+    sqe->fd         = fd                                        ;
+    sqe->addr       = reinterpret_cast<std::uintptr_t> (b.data) ;
+    sqe->len        = static_cast<std::uint32_t> (b.size)       ;
+    sqe->off        = positioned ? b.offset : ~std::uint64_t () ;
+    sqe->buf_index  = static_cast<std::uint16_t> (current)      ;
+    sqe->user_data  = current                                   ;
+
+    sq_array[index] = index;
+
+    __atomic_store_n (sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    ++in_flight;
+
+    for (;;)
+    {
+      auto submitted = details::impl::io_uring_enter (ring_fd, 1, 0, 0);
+      if (submitted >= 0)
+      {
+        break;
+      }
+
+      if (errno == EINTR)
+      {
+        continue;
+      }
+
+      if (errno == EAGAIN || errno == EBUSY)
+      {
+        // Wait only for entries that were submitted, the one above wasn't
+        reap (in_flight > 1, current);
+
+        if (ring_fd >= 0)
+        {
+          continue;
+        }
+      }
+      else
+      {
+        // Take the entry back as the kernel didn't consume it
+        __atomic_store_n (sq_tail, tail, __ATOMIC_RELEASE);
+
+        abandon_ring (current);
+      }
+
+      // The ring is gone and the entry with it, write it synchronously
+      write_sync (b.data, b.size, b.offset);
+      b.size = 0;
+      return;
+    }
+
+    // If the ring fails while waiting, abandon_ring writes and frees the buffer just submitted too
+    while (free_buffers.empty ())
+    {
+      reap (true, no_buffer);
+    }
+
+    current = free_buffers.back ();
+    free_buffers.pop_back ();
+  }
+
+  BPRINTF_INLINE void io_uring_sink::reap (bool wait, std::size_t unsubmitted)
+  {
+    if (ring_fd < 0)
+    {
+      return;
+    }
+
+    if (wait)
+    {
+      while (details::impl::io_uring_enter (ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0)
+      {
+        if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        {
+          abandon_ring (unsubmitted);
+          return;
+        }
+      }
+    }
+
+    auto head = *cq_head;
+    auto tail = __atomic_load_n (cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; ++head)
+    {
+      auto cqe    = static_cast<io_uring_cqe *> (cqes) + (head & *cq_mask);
+      auto index  = static_cast<std::size_t> (cqe->user_data);
+      auto result = cqe->res;
+
+      auto & b = buffers[index];
+
+      if (result < 0)
+      {
+        // The kernel refused the write, retry it synchronously
+        write_sync (b.data, b.size, b.offset);
+      }
+      else if (static_cast<std::size_t> (result) < b.size)
+      {
+        // Short write, write the rest synchronously
+        write_sync (b.data + result, b.size - result, b.offset + result);
+      }
+
+      b.size = 0;
+
+      free_buffers.push_back (index);
+      --in_flight;
+    }
+
+    __atomic_store_n (cq_head, head, __ATOMIC_RELEASE);
+  }
+
+  BPRINTF_INLINE void io_uring_sink::write_sync (
+      cstr_type     data
+    , std::size_t   size
+    , std::uint64_t offset
+    )
+  {
+    while (size > 0)
+    {
+      auto written = positioned
+        ? ::pwrite (fd, data, size, static_cast<off_t> (offset))
+        : ::write (fd, data, size)
+        ;
+
+      if (written < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+
+        BPRINTF_ASSERT (false && "io_uring_sink failed to write");
+        return;
+      }
+
+      data    += written;
+      size    -= static_cast<std::size_t> (written);
+      offset  += static_cast<std::uint64_t> (written);
+    }
+  }
+}
+
+#endif // BPRINTF_HAS_IO_URING_SINK
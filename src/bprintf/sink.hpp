@@ -0,0 +1,212 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_SINK__HPP
+#define BPRINTF_SINK__HPP
+
+#include "core.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+# define BPRINTF_HAS_MMAP_SINK 1
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#   define BPRINTF_HAS_IO_URING_SINK 1
+# endif
+#endif
+
+#ifdef BPRINTF_HAS_MMAP_SINK
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace better_printf
+{
+  // Appends messages into a memory mapped, preallocated log file
+  //  Files are named <base_path>.<n>, when a file is full the sink rolls to the next one
+  //  Writers reserve space with an atomic offset bump so the per-message path is a memcpy
+  class mmap_file_sink
+  {
+  public:
+    BPRINTF_INLINE mmap_file_sink (
+        std::string   base_path
+      , std::size_t   size_limit
+      );
+
+    BPRINTF_INLINE ~mmap_file_sink () noexcept;
+
+    mmap_file_sink (mmap_file_sink const &)             = delete;
+    mmap_file_sink (mmap_file_sink &&)                  = delete;
+
+    mmap_file_sink & operator= (mmap_file_sink const &) = delete;
+    mmap_file_sink & operator= (mmap_file_sink &&)      = delete;
+
+    // False when the log file couldn't be opened or the last roll failed to open the next file
+    //  Messages that don't fit the current file are then dropped, the next one retries the roll
+    BPRINTF_INLINE bool is_open () const noexcept;
+
+    BPRINTF_INLINE void write (chars_type const & chars);
+
+  private:
+    struct segment
+    {
+      int                       fd        ;
+      char_type *               base      ;
+      std::size_t               capacity  ;
+
+      std::atomic<std::size_t>  reserved  ;
+      std::atomic<std::size_t>  committed ;
+      std::atomic<std::size_t>  writers   ;
+    };
+
+    BPRINTF_INLINE segment * open_segment (std::size_t capacity);
+
+    BPRINTF_INLINE void close_segment (segment * s) noexcept;
+
+    // Returns false if the next segment couldn't be opened, full then stays current
+    BPRINTF_INLINE bool roll (segment * full, std::size_t min_capacity);
+
+    BPRINTF_INLINE void reclaim_segments (std::size_t own_writes) noexcept;
+
+    std::string const                     base_path   ;
+    std::size_t const                     size_limit  ;
+
+    std::mutex                            roll_mutex  ;
+    std::size_t                           file_index  ;
+    // Closed segments are kept (unmapped) until no write is in progress
+    //  Rationale: a writer may still touch a segment it loaded just before a roll
+    std::vector<std::unique_ptr<segment>> segments    ;
+    std::atomic<segment *>                current     ;
+    std::atomic<std::size_t>              writes      ;
+    std::atomic<bool>                     roll_failed ;
+  };
+}
+
+#endif // BPRINTF_HAS_MMAP_SINK
+
+#ifdef BPRINTF_HAS_IO_URING_SINK
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace better_printf
+{
+  // Batches messages into registered buffers and submits full buffers to a file or pipe
+  //  with io_uring, completions are reaped without syscalls on later writes and buffers
+  //  are recycled. Falls back to plain write (2) when io_uring isn't available.
+  //  Messages stay in the current buffer until it's full, call flush () to submit it.
+  class io_uring_sink
+  {
+  public:
+    BPRINTF_INLINE explicit io_uring_sink (
+        int           fd
+      , std::size_t   buffer_size   = 64 * 1024
+      , std::size_t   buffer_count  = 8
+      , bool          use_io_uring  = true
+      );
+
+    BPRINTF_INLINE ~io_uring_sink () noexcept;
+
+    io_uring_sink (io_uring_sink const &)             = delete;
+    io_uring_sink (io_uring_sink &&)                  = delete;
+
+    io_uring_sink & operator= (io_uring_sink const &) = delete;
+    io_uring_sink & operator= (io_uring_sink &&)      = delete;
+
+    BPRINTF_INLINE bool uses_io_uring () const noexcept;
+
+    BPRINTF_INLINE void write (chars_type const & chars);
+
+    // Submits the current buffer and waits for all writes to complete
+    //  For regular files the file position is then moved past the written data
+    BPRINTF_INLINE void flush ();
+
+  private:
+    static constexpr std::size_t no_buffer = ~std::size_t ();
+
+    struct buffer
+    {
+      char_type *   data    ;
+      std::size_t   size    ;
+      std::uint64_t offset  ;
+    };
+
+    BPRINTF_INLINE bool setup_ring ();
+
+    BPRINTF_INLINE void teardown_ring () noexcept;
+
+    // The ring failed, finishes in-flight writes synchronously and falls back to write (2)
+    //  unsubmitted is a buffer holding data that isn't in flight (or no_buffer), it's left to the caller
+    BPRINTF_INLINE void abandon_ring (std::size_t unsubmitted);
+
+    BPRINTF_INLINE void submit_current ();
+
+    // If waiting fails the ring is abandoned, see abandon_ring
+    BPRINTF_INLINE void reap (bool wait, std::size_t unsubmitted);
+
+    BPRINTF_INLINE void write_sync (
+        cstr_type     data
+      , std::size_t   size
+      , std::uint64_t offset
+      );
+
+    int const                     fd            ;
+    std::size_t const             buffer_size   ;
+
+    std::mutex                    mutex         ;
+
+    // Regular files are written at explicit offsets so writes may complete in any order,
+    //  pipes and O_APPEND files get one write in flight at a time to keep the order
+    bool                          positioned    ;
+    std::uint64_t                 file_offset   ;
+
+    std::unique_ptr<char_type []> memory        ;
+    std::vector<buffer>           buffers       ;
+    std::vector<std::size_t>      free_buffers  ;
+    std::size_t                   current       ;
+    std::size_t                   in_flight     ;
+
+    int                           ring_fd       ;
+    void *                        sq_ring       ;
+    std::size_t                   sq_ring_size  ;
+    void *                        cq_ring       ;
+    std::size_t                   cq_ring_size  ;
+    void *                        sqes          ;
+    std::size_t                   sqes_size     ;
+
+    unsigned *                    sq_head       ;
+    unsigned *                    sq_tail       ;
+    unsigned *                    sq_mask       ;
+    unsigned *                    sq_array      ;
+    unsigned *                    cq_head       ;
+    unsigned *                    cq_tail       ;
+    unsigned *                    cq_mask       ;
+    void *                        cqes          ;
+  };
+}
+
+#endif // BPRINTF_HAS_IO_URING_SINK
+
+#ifdef BPRINTF_HEADER_ONLY
+# include "sink.cpp"
+#endif
+
+#endif // BPRINTF_SINK__HPP
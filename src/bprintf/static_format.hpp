@@ -0,0 +1,430 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_STATIC_FORMAT__HPP
+#define BPRINTF_STATIC_FORMAT__HPP
+
+#include "core.hpp"
+#include "formatters.hpp"
+
+// static_bsprintf formats messages with constant arguments at compile time:
+//
+//    constexpr auto banner = static_bsprintf<64> ("bprintf v%0%.%1%\n", 1, 2);
+//    bprintf (banner);
+//
+// It supports integers (d, x, X and o specs), strings, string precision and width/alignment
+// in bytes or code points. Width and precision may be taken from an argument.
+// Unsupported specs and results longer than the capacity fail to compile.
+// It relies on C++14 relaxed constexpr, Visual Studio needs the v141 toolset (VS2017) or later.
+// The rest of bprintf doesn't, see BPRINTF_CONSTEXPR14.
+
+#ifndef BPRINTF_HAS_CONSTEXPR14
+# error "static_format.hpp needs C++14 relaxed constexpr, Visual Studio 2017 (v141) or later"
+#endif
+
+namespace better_printf
+{
+  namespace details
+  {
+    // Not constexpr, calling these during constant evaluation makes it fail to compile
+    inline void static_format_overflow ()
+    {
+      BPRINTF_ASSERT (false && "static_bsprintf capacity exceeded");
+    }
+
+    inline void static_format_unsupported ()
+    {
+      BPRINTF_ASSERT (false && "static_bsprintf doesn't support the format spec");
+    }
+  }
+
+  template<std::size_t N>
+  class fixed_chars
+  {
+  public:
+    constexpr fixed_chars () noexcept
+      : chars   {}
+      , length  (0)
+    {
+    }
+
+    constexpr std::size_t size () const noexcept
+    {
+      return length;
+    }
+
+    constexpr std::size_t capacity () const noexcept
+    {
+      return N;
+    }
+
+    constexpr cstr_type data () const noexcept
+    {
+      return chars;
+    }
+
+    constexpr char_type operator[] (std::size_t i) const noexcept
+    {
+      return chars[i];
+    }
+
+    constexpr void push_back (char_type ch)
+    {
+      if (length < N)
+      {
+        chars[length++] = ch;
+      }
+      else
+      {
+        details::static_format_overflow ();
+      }
+    }
+
+    constexpr void append (
+        cstr_type   begin
+      , cstr_type   end
+      )
+    {
+      for (; begin < end; ++begin)
+      {
+        push_back (*begin);
+      }
+    }
+
+    constexpr void append (
+        std::size_t count
+      , char_type   ch
+      )
+    {
+      for (auto iter = 0U; iter < count; ++iter)
+      {
+        push_back (ch);
+      }
+    }
+
+  private:
+    // +1 for the null terminator
+    char_type   chars [N + 1] ;
+    std::size_t length        ;
+  };
+
+  namespace details
+  {
+    struct static_formatter_context
+    {
+      std::size_t   index         ;
+      bool          right_align   ;
+      std::size_t   width         ;
+      width_unit    unit          ;
+      std::size_t   precision     ;
+      char_type     fill          ;
+
+      std::size_t   width_argument      ;
+      std::size_t   precision_argument  ;
+
+      cstr_type     current       ;
+      cstr_type     format_begin  ;
+      cstr_type     format_end    ;
+    };
+
+    constexpr std::size_t static_strlen (cstr_type cstr) noexcept
+    {
+      auto end = cstr;
+      while (*end != null_char)
+      {
+        ++end;
+      }
+      return static_cast<std::size_t> (end - cstr);
+    }
+
+    // Placeholders are parsed by scan_placeholder () shared with scan ()
+    template<std::size_t N>
+    constexpr bool static_scan (
+        static_formatter_context &  context
+      , fixed_chars<N> &            chars
+      )
+    {
+      for (;;)
+      {
+        auto token = scan_placeholder (context);
+
+        chars.append (context.current, token.literal_end);
+
+        context.current = token.next;
+
+        switch (token.kind)
+        {
+        case scan_kind::end:
+          return false;
+        case scan_kind::escape:
+          continue;
+        case scan_kind::placeholder:
+          break;
+        }
+
+        if (context.unit == width_unit::cells)
+        {
+          // Cell widths are only supported at runtime
+          static_format_unsupported ();
+        }
+
+        return true;
+      }
+    }
+
+    // Mirrors utf8_prefix () for bytes and code points, which isn't constexpr
+    constexpr std::size_t static_utf8_prefix (
+        width_unit  unit
+      , cstr_type   buffer
+      , std::size_t size
+      , std::size_t limit
+      )
+    {
+      auto end = limit < size ? limit : size;
+
+      if (unit == width_unit::bytes)
+      {
+        while (end < size && end > 0 && limit - end < 3 && (static_cast<unsigned char> (buffer[end]) & 0xC0U) == 0x80U)
+        {
+          --end;
+        }
+
+        return end;
+      }
+
+      std::size_t count = 0;
+
+      for (end = 0; end < size; ++end)
+      {
+        if ((static_cast<unsigned char> (buffer[end]) & 0xC0U) != 0x80U)
+        {
+          if (count == limit)
+          {
+            break;
+          }
+
+          ++count;
+        }
+      }
+
+      return end;
+    }
+
+    // Code points are counted here as display_width () isn't constexpr
+    template<std::size_t N>
+    constexpr void static_push_buffer (
+        static_formatter_context const &  context
+      , fixed_chars<N> &                  chars
+      , cstr_type                         buffer
+      , std::size_t                       size
+      )
+    {
+      auto width    = context.width ;
+      auto display  = size          ;
+
+      if (context.unit == width_unit::code_points)
+      {
+        display = 0;
+        for (auto iter = 0U; iter < size; ++iter)
+        {
+          display += (static_cast<unsigned char> (buffer[iter]) & 0xC0U) == 0x80U ? 0 : 1;
+        }
+      }
+
+      push_padded (chars, context.right_align, width, display, context.fill, buffer, size);
+    }
+
+    template<std::size_t N>
+    constexpr void static_format_integral (
+        static_formatter_context const &  context
+      , fixed_chars<N> &                  chars
+      , char_type                         prefix
+      , std::uint64_t                     value
+      )
+    {
+      constexpr auto buffer_size = 23U;
+      char_type buffer[buffer_size] {};
+
+      auto begin = buffer_size;
+
+      switch (peek_token (context.format_begin, context.format_end))
+      {
+      case 'x':
+      case 'X':
+        begin = format_digits<16U>  (buffer, buffer_size, value);
+        break;
+      case 'o':
+        begin = format_digits<8U>   (buffer, buffer_size, value);
+        break;
+      case 'd':
+        if (context.format_end - context.format_begin > 1)
+        {
+          // Fixed point specs are only supported at runtime
+          static_format_unsupported ();
+        }
+        begin = format_digits<10U>  (buffer, buffer_size, value);
+        break;
+      default:
+        begin = format_digits<10U>  (buffer, buffer_size, value);
+        break;
+      }
+
+      if (prefix != null_char)
+      {
+        buffer[--begin] = prefix;
+      }
+
+      static_push_buffer (context, chars, buffer + begin, buffer_size - begin);
+    }
+
+    template<std::size_t N, typename TIntegral>
+    constexpr enable_if_signed_integral_t<TIntegral> static_format (
+        static_formatter_context const &  context
+      , fixed_chars<N> &                  chars
+      , TIntegral                         value
+      )
+    {
+      static_format_integral (
+          context
+        , chars
+        , value < 0 ? minus_char : null_char
+        , value < 0 ? 0U - static_cast<std::uint64_t> (value) : static_cast<std::uint64_t> (value)
+        );
+    }
+
+    template<std::size_t N, typename TIntegral>
+    constexpr enable_if_unsigned_integral_t<TIntegral> static_format (
+        static_formatter_context const &  context
+      , fixed_chars<N> &                  chars
+      , TIntegral                         value
+      )
+    {
+      static_format_integral (context, chars, null_char, value);
+    }
+
+    template<std::size_t N>
+    constexpr void static_format (
+        static_formatter_context const &  context
+      , fixed_chars<N> &                  chars
+      , cstr_type                         value
+      )
+    {
+      value = value ? value : "";
+
+      auto size = static_strlen (value);
+
+      static_push_buffer (context, chars, value, size < context.precision ? size : static_utf8_prefix (context.unit, value, size, context.precision));
+    }
+
+    template<std::size_t N>
+    constexpr void static_apply_formatter (
+        static_formatter_context &  context
+      , fixed_chars<N> &            chars
+      )
+    {
+      context.precision = no_precision;
+      static_format (context, chars, "BPRINTF_OUT_OF_BOUNDS");
+    }
+
+    template<std::size_t N, typename THead, typename ...TTail>
+    constexpr void static_apply_formatter (
+        static_formatter_context &  context
+      , fixed_chars<N> &            chars
+      , THead const &               head
+      , TTail const &               ...tail
+      )
+    {
+      if (context.index != 0)
+      {
+        --context.index;
+        static_apply_formatter (context, chars, tail...);
+      }
+      else
+      {
+        static_format (context, chars, head);
+      }
+    }
+  }
+
+  template<std::size_t N, typename ...TArgs>
+  constexpr fixed_chars<N> static_bsprintf (
+      cstr_type       format
+    , TArgs const &   ...args
+    )
+  {
+    fixed_chars<N> chars;
+
+    details::static_formatter_context context {};
+    context.current = format ? format : "";
+
+    while (details::static_scan (context, chars))
+    {
+      details::resolve_arguments (context, args...);
+      details::static_apply_formatter (context, chars, args...);
+    }
+
+    return chars;
+  }
+
+  namespace formatters
+  {
+    template<std::size_t N>
+    void format (
+        details::formatter_context const &  context
+      , fixed_chars<N> const &              value
+      )
+    {
+      BPRINTF_ASSERT (context.format_begin);
+      BPRINTF_ASSERT (context.format_end);
+
+      details::push_string (context, value.data (), value.size ());
+    }
+  }
+
+  template<std::size_t N>
+  void bsprintf (
+      chars_type &            chars
+    , fixed_chars<N> const &  text
+    )
+  {
+    chars.insert (chars.end (), text.data (), text.data () + text.size ());
+  }
+
+  template<std::size_t N>
+  void bprintf (fixed_chars<N> const & text)
+  {
+    auto & chars = details::get_thread_local_chars ();
+
+    bsprintf (chars, text);
+
+    details::write_to_cout (chars);
+  }
+
+  template<typename TSink, std::size_t N>
+  void bfprintf (
+      TSink &                 sink
+    , fixed_chars<N> const &  text
+    )
+  {
+    auto & chars = details::get_thread_local_chars ();
+
+    bsprintf (chars, text);
+
+    sink.write (chars);
+  }
+}
+
+#endif // BPRINTF_STATIC_FORMAT__HPP
@@ -0,0 +1,296 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_HEADER_ONLY
+# include "stdafx.h"
+#endif
+
+#include "unicode.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define BPRINTF_HAS_SSE2 1
+# include <emmintrin.h>
+#endif
+
+namespace better_printf
+{
+  namespace details
+  {
+    namespace impl
+    {
+      struct code_point_range
+      {
+        std::uint32_t first ;
+        std::uint32_t last  ;
+      };
+
+      template<std::size_t N>
+      inline bool in_ranges (
+          code_point_range const (&ranges) [N]
+        , std::uint32_t             cp
+        ) noexcept
+      {
+        for (auto & range : ranges)
+        {
+          if (cp < range.first)
+          {
+            return false;
+          }
+
+          if (cp <= range.last)
+          {
+            return true;
+          }
+        }
+
+        return false;
+      }
+
+      inline bool is_wide (std::uint32_t cp) noexcept
+      {
+        // Sorted, from the East Asian Width property (W and F)
+        static constexpr code_point_range const wide_ranges [] =
+        {
+          { 0x1100  , 0x115F  } ,
+          { 0x2E80  , 0x303E  } ,
+          { 0x3041  , 0x33FF  } ,
+          { 0x3400  , 0x4DBF  } ,
+          { 0x4E00  , 0x9FFF  } ,
+          { 0xA000  , 0xA4CF  } ,
+          { 0xAC00  , 0xD7A3  } ,
+          { 0xF900  , 0xFAFF  } ,
+          { 0xFE30  , 0xFE4F  } ,
+          { 0xFF00  , 0xFF60  } ,
+          { 0xFFE0  , 0xFFE6  } ,
+          { 0x1F300 , 0x1F64F } ,
+          { 0x1F900 , 0x1F9FF } ,
+          { 0x20000 , 0x2FFFD } ,
+          { 0x30000 , 0x3FFFD } ,
+        };
+
+        return in_ranges (wide_ranges, cp);
+      }
+
+      inline bool is_zero_width (std::uint32_t cp) noexcept
+      {
+        // Sorted, combining marks, zero width spaces/joiners and variation selectors
+        static constexpr code_point_range const zero_width_ranges [] =
+        {
+          { 0x0300  , 0x036F  } ,
+          { 0x200B  , 0x200F  } ,
+          { 0x20D0  , 0x20FF  } ,
+          { 0xFE00  , 0xFE0F  } ,
+          { 0xFE20  , 0xFE2F  } ,
+        };
+
+        return in_ranges (zero_width_ranges, cp);
+      }
+
+      inline bool is_continuation (unsigned char ch) noexcept
+      {
+        return (ch & 0xC0U) == 0x80U;
+      }
+
+      // Cells of the code point starting at buffer[iter], length is set to its size in bytes
+      //  Invalid or truncated sequences count as one byte and one cell
+      inline std::size_t next_cells (
+          cstr_type     buffer
+        , std::size_t   size
+        , std::size_t   iter
+        , std::size_t & length
+        ) noexcept
+      {
+        auto lead = static_cast<unsigned char> (buffer[iter]);
+
+        length = 1;
+
+        if (lead < 0x80U)
+        {
+          return 1;
+        }
+
+        auto sequence =
+            lead >= 0xF0U ? 4U
+          : lead >= 0xE0U ? 3U
+          : lead >= 0xC0U ? 2U
+          : 1U
+          ;
+
+        std::uint32_t cp = sequence == 4U ? lead & 0x07U
+          : sequence == 3U ? lead & 0x0FU
+          : lead & 0x1FU
+          ;
+
+        auto valid = sequence > 1U && iter + sequence <= size;
+
+        for (auto cont = 1U; valid && cont < sequence; ++cont)
+        {
+          auto ch = static_cast<unsigned char> (buffer[iter + cont]);
+          valid   = is_continuation (ch);
+          cp      = (cp << 6) | (ch & 0x3FU);
+        }
+
+        if (!valid)
+        {
+          return 1;
+        }
+
+        length = sequence;
+
+        return is_zero_width (cp) ? 0 : is_wide (cp) ? 2 : 1;
+      }
+    }
+
+    BPRINTF_INLINE std::size_t utf8_code_points (
+        cstr_type   buffer
+      , std::size_t size
+      ) noexcept
+    {
+      BPRINTF_ASSERT (buffer || size == 0);
+
+      std::size_t count = 0;
+      std::size_t iter  = 0;
+
+#ifdef BPRINTF_HAS_SSE2
+      // Continuation bytes are 0x80-0xBF, as signed bytes that's -128 to -65
+      //  so every byte greater than -65 starts a code point.
+      //  Each compare yields -1 per starting byte, subtracting accumulates counts per lane
+      //  for up to 255 blocks before the lanes are summed with sad_epu8.
+      auto const threshold  = _mm_set1_epi8 (-65);
+      auto const zero       = _mm_setzero_si128 ();
+
+      while (size - iter >= 16)
+      {
+        auto blocks = (size - iter) / 16;
+        blocks      = blocks < 255 ? blocks : 255;
+
+        auto accumulator = zero;
+
+        for (auto block = 0U; block < blocks; ++block, iter += 16)
+        {
+          auto chars  = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (buffer + iter));
+          accumulator = _mm_sub_epi8 (accumulator, _mm_cmpgt_epi8 (chars, threshold));
+        }
+
+        auto sums = _mm_sad_epu8 (accumulator, zero);
+        count += static_cast<std::size_t> (_mm_cvtsi128_si32 (sums) + _mm_extract_epi16 (sums, 4));
+      }
+#endif
+
+      for (; iter < size; ++iter)
+      {
+        count += impl::is_continuation (static_cast<unsigned char> (buffer[iter])) ? 0 : 1;
+      }
+
+      return count;
+    }
+
+    BPRINTF_INLINE std::size_t utf8_cells (
+        cstr_type   buffer
+      , std::size_t size
+      ) noexcept
+    {
+      BPRINTF_ASSERT (buffer || size == 0);
+
+      std::size_t count = 0;
+      std::size_t iter  = 0;
+
+      while (iter < size)
+      {
+#ifdef BPRINTF_HAS_SSE2
+        // ASCII blocks are 1 cell per byte
+        if (iter + 16 <= size)
+        {
+          auto chars = _mm_loadu_si128 (reinterpret_cast<__m128i const *> (buffer + iter));
+          if (_mm_movemask_epi8 (chars) == 0)
+          {
+            count += 16;
+            iter  += 16;
+            continue;
+          }
+        }
+#endif
+
+        std::size_t length = 1;
+
+        count += impl::next_cells (buffer, size, iter, length);
+        iter  += length;
+      }
+
+      return count;
+    }
+
+    BPRINTF_INLINE std::size_t utf8_prefix (
+        width_unit  unit
+      , cstr_type   buffer
+      , std::size_t size
+      , std::size_t limit
+      ) noexcept
+    {
+      BPRINTF_ASSERT (buffer || size == 0);
+
+      if (unit == width_unit::bytes)
+      {
+        if (limit >= size)
+        {
+          return size;
+        }
+
+        // Backs up to the start of the code point the limit falls in, at most 3 continuation
+        //  bytes so that text that isn't UTF-8 is still cut close to the limit
+        auto end = limit;
+        while (end > 0 && limit - end < 3 && impl::is_continuation (static_cast<unsigned char> (buffer[end])))
+        {
+          --end;
+        }
+
+        return end;
+      }
+
+      std::size_t count = 0;
+      std::size_t iter  = 0;
+
+      while (iter < size)
+      {
+        std::size_t length  = 1;
+        std::size_t units   = 1;
+
+        if (unit == width_unit::cells)
+        {
+          units = impl::next_cells (buffer, size, iter, length);
+        }
+        else
+        {
+          while (iter + length < size && impl::is_continuation (static_cast<unsigned char> (buffer[iter + length])))
+          {
+            ++length;
+          }
+        }
+
+        // Zero width code points after the limit stay with the code point they combine with
+        if (count + units > limit)
+        {
+          break;
+        }
+
+        count += units;
+        iter  += length;
+      }
+
+      return iter;
+    }
+  }
+}
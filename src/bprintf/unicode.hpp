@@ -0,0 +1,68 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_UNICODE__HPP
+#define BPRINTF_UNICODE__HPP
+
+#include "core.hpp"
+
+namespace better_printf
+{
+  namespace details
+  {
+    // Number of UTF-8 code points in buffer, ie the number of bytes that aren't continuation bytes
+    BPRINTF_INLINE std::size_t utf8_code_points (
+        cstr_type   buffer
+      , std::size_t size
+      ) noexcept;
+
+    // Number of terminal cells buffer occupies, East Asian wide code points take 2 cells
+    //  and combining marks take none
+    BPRINTF_INLINE std::size_t utf8_cells (
+        cstr_type   buffer
+      , std::size_t size
+      ) noexcept;
+
+    // Size in bytes of the longest prefix of buffer at most limit units wide
+    //  The prefix never ends inside a UTF-8 sequence
+    BPRINTF_INLINE std::size_t utf8_prefix (
+        width_unit  unit
+      , cstr_type   buffer
+      , std::size_t size
+      , std::size_t limit
+      ) noexcept;
+
+    inline std::size_t display_width (
+        width_unit  unit
+      , cstr_type   buffer
+      , std::size_t size
+      ) noexcept
+    {
+      switch (unit)
+      {
+      case width_unit::code_points:
+        return utf8_code_points (buffer, size);
+      case width_unit::cells:
+        return utf8_cells (buffer, size);
+      case width_unit::bytes:
+      default:
+        return size;
+      }
+    }
+  }
+}
+
+#endif // BPRINTF_UNICODE__HPP
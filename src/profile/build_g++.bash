@@ -0,0 +1 @@
+g++ -Wall -g -O3 --std=c++14 -pthread profile.cpp ../bprintf/core.cpp ../bprintf/formatters.cpp ../bprintf/unicode.cpp -I. -DNDEBUG -o exe.profile.g++
@@ -0,0 +1 @@
+g++ -Wall -g -O3 --std=c++14 -pthread profile.cpp -I. -DNDEBUG -DBPRINTF_HEADER_ONLY -o exe.profile.header_only.g++
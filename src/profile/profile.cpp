@@ -0,0 +1,380 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+// Profiles each formatter path in isolation and reports hardware performance counters per call
+//  (cycles, instructions, branch misses and L1 data cache misses) read with perf_event_open.
+//  Where the counters aren't available, only ns/call is reported.
+//
+// Usage: profile [calls]
+
+#include "stdafx.h"
+
+#include "../bprintf/bprintf.hpp"
+
+#if defined(__linux__) && defined(__has_include)
+# if __has_include(<linux/perf_event.h>)
+#   define BPRINTF_HAS_PERF_EVENT
+# endif
+#endif
+
+#ifdef BPRINTF_HAS_PERF_EVENT
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace
+{
+  using namespace better_printf;
+
+  enum counter_id
+  {
+    cycles        ,
+    instructions  ,
+    branch_misses ,
+    l1d_misses    ,
+    counter_count ,
+  };
+
+  cstr_type const counter_names [counter_count] =
+  {
+    "cycles"        ,
+    "instructions"  ,
+    "branch-misses" ,
+    "L1d-misses"    ,
+  };
+
+  // Each counter is opened on its own so that a counter the CPU or VM lacks doesn't disable the others
+  class perf_counters
+  {
+  public:
+    perf_counters () noexcept
+    {
+      for (auto & fd : fds)
+      {
+        fd = -1;
+      }
+
+#ifdef BPRINTF_HAS_PERF_EVENT
+      open (cycles        , PERF_TYPE_HARDWARE  , PERF_COUNT_HW_CPU_CYCLES);
+      open (instructions  , PERF_TYPE_HARDWARE  , PERF_COUNT_HW_INSTRUCTIONS);
+      open (branch_misses , PERF_TYPE_HARDWARE  , PERF_COUNT_HW_BRANCH_MISSES);
+      open (
+          l1d_misses
+        , PERF_TYPE_HW_CACHE
+        ,     PERF_COUNT_HW_CACHE_L1D
+          | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+          | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+        );
+#endif
+    }
+
+    ~perf_counters () noexcept
+    {
+#ifdef BPRINTF_HAS_PERF_EVENT
+      for (auto fd : fds)
+      {
+        if (fd >= 0)
+        {
+          ::close (fd);
+        }
+      }
+#endif
+    }
+
+    perf_counters (perf_counters const &)             = delete;
+    perf_counters & operator= (perf_counters const &) = delete;
+
+    bool available (counter_id id) const noexcept
+    {
+      return fds[id] >= 0;
+    }
+
+    void start () noexcept
+    {
+#ifdef BPRINTF_HAS_PERF_EVENT
+      for (auto fd : fds)
+      {
+        if (fd >= 0)
+        {
+          ::ioctl (fd, PERF_EVENT_IOC_RESET   , 0);
+          ::ioctl (fd, PERF_EVENT_IOC_ENABLE  , 0);
+        }
+      }
+#endif
+    }
+
+    // Counts are scaled up when the kernel multiplexed a counter
+    void stop (double (& values) [counter_count]) noexcept
+    {
+      for (auto & value : values)
+      {
+        value = 0;
+      }
+
+#ifdef BPRINTF_HAS_PERF_EVENT
+      for (auto fd : fds)
+      {
+        if (fd >= 0)
+        {
+          ::ioctl (fd, PERF_EVENT_IOC_DISABLE , 0);
+        }
+      }
+
+      for (auto iter = 0U; iter < counter_count; ++iter)
+      {
+        // value, time enabled, time running
+        std::uint64_t read_format [3] {};
+
+        if (fds[iter] >= 0 && ::read (fds[iter], read_format, sizeof (read_format)) == sizeof (read_format))
+        {
+          values[iter] = read_format[2] > 0
+            ? static_cast<double> (read_format[0]) * read_format[1] / read_format[2]
+            : 0.0
+            ;
+        }
+      }
+#endif
+    }
+
+  private:
+#ifdef BPRINTF_HAS_PERF_EVENT
+    void open (
+        counter_id      id
+      , std::uint32_t   type
+      , std::uint64_t   config
+      ) noexcept
+    {
+      perf_event_attr attr {};
+
+      attr.size           = sizeof (attr);
+      attr.type           = type;
+      attr.config         = config;
+      attr.disabled       = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv     = 1;
+      attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      fds[id] = static_cast<int> (::syscall (SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+
+    int fds [counter_count] ;
+  };
+
+  std::uint64_t calls     = 1000000;
+  std::uint64_t checksum  = 0;
+
+  // Runs action calls times and prints ns and counters per call
+  template<typename TAction>
+  void profile (
+      perf_counters & counters
+    , cstr_type       name
+    , TAction &&      action
+    )
+  {
+    // Warm up caches and branch predictors
+    for (auto iter = 0ULL; iter < calls / 10; ++iter)
+    {
+      checksum += action (iter);
+    }
+
+    double values [counter_count];
+
+    counters.start ();
+    auto past = std::chrono::high_resolution_clock::now ();
+
+    for (auto iter = 0ULL; iter < calls; ++iter)
+    {
+      checksum += action (iter);
+    }
+
+    auto now  = std::chrono::high_resolution_clock::now ();
+    counters.stop (values);
+
+    auto ns   = std::chrono::duration_cast<std::chrono::nanoseconds> (now - past).count ();
+
+    chars_type row;
+    bsprintf (row, "%0-28%%1+10.2:f%", name, static_cast<double> (ns) / calls);
+
+    for (auto iter = 0U; iter < counter_count; ++iter)
+    {
+      if (counters.available (static_cast<counter_id> (iter)))
+      {
+        bsprintf (row, "%0+15.2:f%", values[iter] / calls);
+      }
+      else
+      {
+        bsprintf (row, "%0+15%", "n/a");
+      }
+    }
+
+    row.push_back (details::newline_char);
+
+    details::write_to_cout (row);
+  }
+
+  // Profiles a formatter on its own, spec is scanned once up front
+  template<typename TFormat>
+  void profile_formatter (
+      perf_counters & counters
+    , cstr_type       name
+    , cstr_type       spec
+    , TFormat &&      format
+    )
+  {
+    chars_type chars;
+    chars.reserve (details::initial_buffer);
+
+    details::formatter_context context (chars, spec);
+    details::scan (context);
+
+    profile (
+        counters
+      , name
+      , [&] (std::uint64_t iter)
+        {
+          chars.clear ();
+          format (context, iter);
+          return chars.size ();
+        }
+      );
+  }
+}
+
+int main (int argc, char const * argv [])
+{
+  if (argc > 1)
+  {
+    calls = std::strtoull (argv[1], nullptr, 10);
+    calls = calls > 0 ? calls : 1;
+  }
+
+  perf_counters counters;
+
+  bprintf ("Profiling %0% calls per path, per call:\n", calls);
+  bprintf (
+      "%0-28%%1+10%%2+15%%3+15%%4+15%%5+15%\n"
+    , "path"
+    , "ns"
+    , counter_names[cycles]
+    , counter_names[instructions]
+    , counter_names[branch_misses]
+    , counter_names[l1d_misses]
+    );
+
+  {
+    chars_type chars;
+    chars.reserve (details::initial_buffer);
+
+    // scan only, the placeholders aren't formatted
+    profile (
+        counters
+      , "scan (4 placeholders)"
+      , [&] (std::uint64_t)
+        {
+          chars.clear ();
+          details::formatter_context context (chars, "Row %0%: %1+10% 0x%2:X% %%done %3-8.2:f%\n");
+          while (details::scan (context))
+          {
+          }
+          return chars.size ();
+        }
+      );
+  }
+
+  auto int64  = [] (details::formatter_context const & context, std::uint64_t iter)
+    {
+      details::format__int64 (context, -1234567890LL - static_cast<std::int64_t> (iter));
+    };
+
+  auto uint64 = [] (details::formatter_context const & context, std::uint64_t iter)
+    {
+      details::format__uint64 (context, 1234567890ULL + iter);
+    };
+
+  profile_formatter (counters, "format__int64 (10)"   , "%0%"     , int64);
+  profile_formatter (counters, "format__int64 (16)"   , "%0:x%"   , int64);
+  profile_formatter (counters, "format__int64 (8)"    , "%0:o%"   , int64);
+  profile_formatter (counters, "format__int64 (d2,)"  , "%0:d2,%" , int64);
+  profile_formatter (counters, "format__uint64 (10)"  , "%0%"     , uint64);
+  profile_formatter (counters, "format__uint64 (16)"  , "%0:x%"   , uint64);
+  profile_formatter (counters, "format__uint64 (8)"   , "%0:o%"   , uint64);
+  profile_formatter (counters, "format__uint64 (d2,)" , "%0:d2,%" , uint64);
+
+  auto real   = [] (details::formatter_context const & context, std::uint64_t iter)
+    {
+      details::format__double (context, 3.14159265 + static_cast<double> (iter));
+    };
+
+  profile_formatter (counters, "format__double (a)"   , "%0:a%"   , real);
+  profile_formatter (counters, "format__double (e)"   , "%0:e%"   , real);
+  profile_formatter (counters, "format__double (f)"   , "%0:f%"   , real);
+  profile_formatter (counters, "format__double (g)"   , "%0:g%"   , real);
+  profile_formatter (counters, "format__double (G)"   , "%0:G%"   , real);
+  profile_formatter (counters, "format__double (.2f)" , "%0.2:f%" , real);
+
+  auto buffer = [] (details::formatter_context const & context, std::uint64_t iter)
+    {
+      details::push_buffer (context, "Hello there", 6 + (iter & 3));
+    };
+
+  profile_formatter (counters, "push_buffer"            , "%0%"     , buffer);
+  profile_formatter (counters, "push_buffer (+20)"      , "%0+20%"  , buffer);
+  profile_formatter (counters, "push_buffer (-20)"      , "%0-20%"  , buffer);
+  profile_formatter (counters, "push_buffer (+20u)"     , "%0+20u%" , buffer);
+  profile_formatter (counters, "push_buffer (+20w)"     , "%0+20w%" , buffer);
+
+  // Long non-ASCII text so that the SSE2 code point kernel and the cell walk do the work
+  std::string long_text;
+  for (auto iter = 0U; iter < 1000U; ++iter)
+  {
+    long_text += "Åsa日本";
+  }
+
+  auto long_buffer = [&] (details::formatter_context const & context, std::uint64_t)
+    {
+      details::push_buffer (context, long_text.data (), long_text.size ());
+    };
+
+  profile_formatter (counters, "push_buffer (long, +8000u)", "%0+8000u%", long_buffer);
+  profile_formatter (counters, "push_buffer (long, +8000w)", "%0+8000w%", long_buffer);
+
+  cstr_type const cstrs [] = { "Yo", "Yo yo", "Something", "Something else" };
+
+  auto cstr   = [&] (details::formatter_context const & context, std::uint64_t iter)
+    {
+      formatters::format (context, cstrs[iter & 3]);
+    };
+
+  std::string const strings [] = { "Yo", "Yo yo", "Something", "Something else" };
+
+  auto string = [&] (details::formatter_context const & context, std::uint64_t iter)
+    {
+      formatters::format (context, strings[iter & 3]);
+    };
+
+  profile_formatter (counters, "format (cstr)"          , "%0%"     , cstr);
+  profile_formatter (counters, "format (cstr, +20)"     , "%0+20%"  , cstr);
+  profile_formatter (counters, "format (std::string)"   , "%0%"     , string);
+  profile_formatter (counters, "format (std::string, +20)", "%0+20%", string);
+
+  // Keeps the formatted output observable
+  bprintf ("Checksum: %0%\n", checksum);
+
+  return 0;
+}
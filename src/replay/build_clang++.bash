@@ -0,0 +1 @@
+clang++ -Wall -g -O3 --std=c++14 -pthread replay.cpp ../bprintf/core.cpp ../bprintf/formatters.cpp ../bprintf/unicode.cpp ../bprintf/recorder.cpp -I. -DNDEBUG -o exe.replay.clang++
@@ -0,0 +1 @@
+g++ -Wall -g -O3 --std=c++14 -pthread replay.cpp -I. -DNDEBUG -DBPRINTF_HEADER_ONLY -o exe.replay.header_only.g++
@@ -0,0 +1,90 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+// Replays a trace recorded with BPRINTF_ENABLE_RECORDER through bsprintf to measure throughput
+//  on a production distribution of formats and arguments.
+//
+// Usage: replay <trace file> [iterations]
+
+#include "stdafx.h"
+
+#include "../bprintf/bprintf.hpp"
+#include "../bprintf/recorder.hpp"
+
+int main (int argc, char const * argv [])
+{
+  using namespace better_printf;
+
+  if (argc < 2)
+  {
+    bprintf ("Usage: %0% <trace file> [iterations]\n", argv[0]);
+    return 1;
+  }
+
+  auto path       = argv[1];
+  auto iterations = argc > 2 ? std::strtoull (argv[2], nullptr, 10) : 100ULL;
+
+  std::vector<trace_record> records;
+  if (!load_trace (path, records))
+  {
+    bprintf ("Failed to load trace: %0% (%1% records loaded)\n", path, records.size ());
+    return 1;
+  }
+
+  if (records.empty ())
+  {
+    bprintf ("Trace is empty: %0%\n", path);
+    return 1;
+  }
+
+  chars_type buffer;
+  buffer.reserve (details::initial_buffer);
+
+  auto bytes  = 0ULL;
+
+  auto past   = std::chrono::high_resolution_clock::now ();
+
+  for (auto iter = 0ULL; iter < iterations; ++iter)
+  {
+    for (auto & record : records)
+    {
+      buffer.clear ();
+      replay_record (buffer, record);
+      bytes += buffer.size ();
+    }
+  }
+
+  auto now    = std::chrono::high_resolution_clock::now ();
+  auto ns     = std::chrono::duration_cast<std::chrono::nanoseconds> (now - past).count ();
+  auto calls  = iterations * records.size ();
+
+  bprintf (
+      "Replayed %0% records x %1% iterations\n"
+      "%2-20%: %3%ms\n"
+      "%4-20%: %5%\n"
+      "%6-20%: %7%\n"
+    , records.size ()
+    , iterations
+    , "Total"
+    , ns / 1000000
+    , "ns/call"
+    , static_cast<double> (ns) / calls
+    , "MB/s"
+    , ns > 0 ? bytes * 1000.0 / ns : 0.0
+    );
+
+  return 0;
+}
@@ -0,0 +1 @@
+g++ -Wall -g -O3 --std=c++14 -pthread test_suite.cpp test_linkage.cpp test_sink.cpp test_parallel.cpp test_recorder.cpp test_log.cpp test_streaming.cpp test_fixed.cpp test_unicode.cpp test_repeated.cpp test_precision.cpp test_enum.cpp -I. -DNDEBUG -DBPRINTF_HEADER_ONLY -o exe.bprintf.header_only.g++
@@ -0,0 +1 @@
+g++ -Wall -g -O3 --std=c++14 -pthread test_suite.cpp test_linkage.cpp test_sink.cpp test_parallel.cpp test_recorder.cpp test_log.cpp test_streaming.cpp test_fixed.cpp test_unicode.cpp test_repeated.cpp test_precision.cpp test_enum.cpp ../bprintf/core.cpp ../bprintf/formatters.cpp ../bprintf/sink.cpp ../bprintf/parallel.cpp ../bprintf/unicode.cpp ../bprintf/recorder.cpp -I. -DNDEBUG -DBPRINTF_ENABLE_RECORDER -o exe.bprintf.recorder.g++
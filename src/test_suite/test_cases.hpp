@@ -0,0 +1,81 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#ifndef BPRINTF_TEST_CASES__HPP
+#define BPRINTF_TEST_CASES__HPP
+
+#include <string>
+
+#include "../bprintf/bprintf.hpp"
+
+// Counts the checked cases of one test, failures print what went wrong and report ()
+//  prints "<name> test: <passed> of <cases> cases passed"
+class test_cases
+{
+public:
+  explicit test_cases (better_printf::cstr_type name)
+    : name    (name)
+    , cases   (0)
+    , passed  (0)
+  {
+  }
+
+  test_cases (test_cases const &)             = delete;
+  test_cases & operator= (test_cases const &) = delete;
+
+  bool check (bool result)
+  {
+    ++cases;
+    passed += result ? 1 : 0;
+
+    return result;
+  }
+
+  // Formats args with format and compares the result with expected
+  template<typename ...TArgs>
+  bool check_format (
+      better_printf::cstr_type  format
+    , std::string const &       expected
+    , TArgs const &             ...args
+    )
+  {
+    using namespace better_printf;
+
+    chars_type chars;
+    bsprintf (chars, format, args...);
+
+    auto result = std::string (chars.begin (), chars.end ());
+
+    if (result != expected)
+    {
+      bprintf ("%0% test: '%1%' gave '%2%', expected '%3%'\n", name, format, result, expected);
+    }
+
+    return check (result == expected);
+  }
+
+  void report () const
+  {
+    better_printf::bprintf ("%0% test: %1% of %2% cases passed\n", name, passed, cases);
+  }
+
+private:
+  better_printf::cstr_type  name    ;
+  int                       cases   ;
+  int                       passed  ;
+};
+
+#endif // BPRINTF_TEST_CASES__HPP
@@ -0,0 +1,53 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include "../bprintf/formatters.hpp"
+
+enum class TestPermission
+{
+  none    = 0   ,
+  read    = 1   ,
+  write   = 2   ,
+  execute = 10  ,
+  denied  = -1  ,
+};
+
+BPRINTF_ENUM (TestPermission, none, read, write, execute, denied)
+
+#include "test_cases.hpp"
+
+void test__enum ()
+{
+  test_cases cases ("Enum");
+
+  // Registered names, also padded
+  cases.check_format ("%0%"       , "read"      , TestPermission::read);
+  cases.check_format ("%0-7%|"    , "write  |"  , TestPermission::write);
+  cases.check_format ("%0%"       , "3"         , static_cast<TestPermission> (3));
+
+  // An integer spec formats the value instead of the name
+  cases.check_format ("%0:d%"     , "10"        , TestPermission::execute);
+  cases.check_format ("%0:x%"     , "A"         , TestPermission::execute);
+  cases.check_format ("%0:X%"     , "A"         , TestPermission::execute);
+  cases.check_format ("%0:o%"     , "12"        , TestPermission::execute);
+  cases.check_format ("%0:d%"     , "-1"        , TestPermission::denied);
+  cases.check_format ("%0+4:d%"   , "   2"      , TestPermission::write);
+  cases.check_format ("%0:d1%"    , "1.0"       , TestPermission::execute);
+
+  cases.report ();
+}
@@ -0,0 +1,66 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "test_cases.hpp"
+
+void test__fixed ()
+{
+  test_cases cases ("Fixed");
+
+  // No decimals
+  cases.check_format ("%0:d0%"  , "123"                             , 123);
+  cases.check_format ("%0:d0,%" , "1,234,567"                       , 1234567);
+  cases.check_format ("%0:d0t%" , "-42"                             , -42);
+
+  // Largest scale a uint64 fills and beyond, fraction digits are padded with zeros
+  cases.check_format ("%0:d20%" , "0.00000000000000000001"          , 1);
+  cases.check_format ("%0:d25%" , "0.0000000000000000000000001"     , 1);
+  cases.check_format ("%0:d22%" , "0.0000000000000000012345"        , 12345ULL);
+  cases.check_format ("%0:d64%" , "0." + std::string (63, '0') + "1", 1);
+
+  // Scales above max_fixed_scale are rejected, also when the digit run would overflow
+  cases.check_format ("%0:d65%" , "5"                               , 5);
+  cases.check_format ("%0:d99999999999999999999999%", "5", 5);
+
+  // Negative values with a zero integer part
+  cases.check_format ("%0:d2%"  , "-0.05"                           , -5);
+  cases.check_format ("%0:d3t%" , "-0.05"                           , -50);
+
+  // Trimming
+  cases.check_format ("%0:d2t%" , "1"                               , 100);
+  cases.check_format ("%0:d8t%" , "0"                               , 0);
+  cases.check_format ("%0:d3t%" , "1.5"                             , 1500);
+  cases.check_format ("%0:d3t,%", "123,456,789"                     , 123456789000LL);
+  cases.check_format ("%0:d2%"  , "1.00"                            , 100);
+
+  // Grouping keeps the zeros inside a group
+  cases.check_format ("%0:d0,%" , "1,000,005"                       , 1000005);
+  cases.check_format ("%0:d2,%" , "1,000.00"                        , 100000);
+
+  // Extremes, the largest scale that still splits off an integer part and INT64_MIN
+  cases.check_format ("%0:d19%" , "1.8446744073709551615"           , std::numeric_limits<std::uint64_t>::max ());
+  cases.check_format ("%0:d2,%" , "184,467,440,737,095,516.15"      , std::numeric_limits<std::uint64_t>::max ());
+  cases.check_format ("%0:d2%"  , "-92233720368547758.08"           , std::numeric_limits<std::int64_t>::min ());
+  cases.check_format ("%0%"     , "-9223372036854775808"            , std::numeric_limits<std::int64_t>::min ());
+
+  cases.report ();
+}
@@ -0,0 +1,85 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include "../bprintf/log.hpp"
+
+namespace
+{
+  int evaluated = 0;
+
+  int evaluate ()
+  {
+    return ++evaluated;
+  }
+}
+
+void test__log ()
+{
+  using namespace better_printf;
+
+  set_log_level (log_level::info);
+
+  BPRINTF_LOG (info, "Log test: %0% %1%", "info is enabled", 42);
+  BPRINTF_LOG (debug, "Log test: debug is disabled %0%", evaluate ());
+
+  for (auto iter = 0; iter < 10; ++iter)
+  {
+    BPRINTF_LOG_EVERY_N (warning, 5, "Log test: every 5th call, call %0%", iter);
+  }
+
+  // n == 0 logs every call instead of dividing by zero
+  for (auto iter = 0; iter < 2; ++iter)
+  {
+    BPRINTF_LOG_EVERY_N (warning, 0, "Log test: every call with n 0, call %0%", iter);
+  }
+
+  for (auto iter = 0; iter < 100; ++iter)
+  {
+    BPRINTF_LOG_RATE_LIMITED (error, 1, 3, "Log test: rate limited to a burst of 3, call %0%", iter);
+  }
+
+  set_log_level (log_level::off);
+
+  BPRINTF_LOG (fatal, "Log test: off %0%", evaluate ());
+
+  set_log_level (log_level::info);
+
+  bprintf ("Log test: %0% suppressed arguments evaluated\n", evaluated);
+
+  // 10 per second is one token per 100ms, after the initial burst of 5 refills 250ms apart must
+  //  add up to 2 + 3 + 2 + 3 tokens rather than 2 + 2 + 2 + 2, losing the 50ms remainder each time
+  details::token_bucket bucket;
+
+  auto granted  = 0;
+  auto now      = 1000000000LL;
+
+  for (auto iter = 0; iter < 5; ++iter, now += 250000000LL)
+  {
+    if (bucket.try_refill (10, 5, now))
+    {
+      ++granted;
+    }
+
+    while (bucket.try_take ())
+    {
+      ++granted;
+    }
+  }
+
+  bprintf ("Log test: %0% rate limited tokens (expected 15)\n", granted);
+}
@@ -0,0 +1,164 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include "../bprintf/parallel.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+void test__parallel ()
+{
+  using namespace better_printf;
+
+  std::vector<int> records (100000);
+  for (auto iter = 0U; iter < records.size (); ++iter)
+  {
+    records[iter] = static_cast<int> (iter);
+  }
+
+  auto formatter = [] (chars_type & chars, int record)
+    {
+      bsprintf (chars, "Row %0+6%: 0x%0:X% %1:d2%\n", record, record * 7);
+    };
+
+  chars_type serial;
+  for (auto record : records)
+  {
+    formatter (serial, record);
+  }
+
+  chars_type parallel;
+  bsprintf_parallel (parallel, records.begin (), records.end (), formatter, 4);
+
+  bprintf (
+      "Parallel test: %0% (%1% bytes)\n"
+    , serial == parallel ? "identical" : "MISMATCH"
+    , parallel.size ()
+    );
+
+  // Chunks reach the sink in order, one write per chunk
+  struct collect_sink
+  {
+    chars_type  chars   ;
+    std::size_t writes  ;
+
+    void write (chars_type const & formatted)
+    {
+      chars.insert (chars.end (), formatted.begin (), formatted.end ());
+      ++writes;
+    }
+  };
+
+  collect_sink sink { chars_type (), 0 };
+  bfprintf_parallel (sink, records.begin (), records.end (), formatter, 4);
+
+  bprintf (
+      "Parallel sink test: %0% (%1% writes)\n"
+    , serial == sink.chars ? "identical" : "MISMATCH"
+    , sink.writes
+    );
+
+  // bprintf from the formatter or the sink clears the thread-local buffer of the calling thread,
+  //  the first chunk must not be formatted into it
+  struct clearing_sink
+  {
+    chars_type  chars ;
+
+    void write (chars_type const & formatted)
+    {
+      details::get_thread_local_chars ();
+      chars.insert (chars.end (), formatted.begin (), formatted.end ());
+    }
+  };
+
+  clearing_sink clearing { chars_type () };
+  bfprintf_parallel (
+      clearing
+    , records.begin ()
+    , records.end ()
+    , [&formatter] (chars_type & chars, int record)
+      {
+        details::get_thread_local_chars ();
+        formatter (chars, record);
+      }
+    , 4
+    );
+
+  bprintf (
+      "Parallel thread-local test: %0%\n"
+    , serial == clearing.chars ? "identical" : "MISMATCH"
+    );
+
+  // Callers on several threads share the pool workers and its buffers
+  chars_type concurrent[3];
+  {
+    std::vector<std::thread> callers;
+    for (auto & chars : concurrent)
+    {
+      callers.emplace_back ([&chars, &records, &formatter] ()
+        {
+          bsprintf_parallel (chars, records.begin (), records.end (), formatter, 8);
+        });
+    }
+
+    for (auto & caller : callers)
+    {
+      caller.join ();
+    }
+  }
+
+  auto identical = std::all_of (
+      std::begin (concurrent)
+    , std::end (concurrent)
+    , [&serial] (chars_type const & chars) { return chars == serial; }
+    );
+
+  // A throwing formatter surfaces on the calling thread
+  auto thrown = false;
+  try
+  {
+    bsprintf_parallel (
+        parallel
+      , records.begin ()
+      , records.end ()
+      , [] (chars_type & chars, int record)
+        {
+          if (record == 90000)
+          {
+            throw std::runtime_error ("record");
+          }
+
+          bsprintf (chars, "%0%", record);
+        }
+      , 4
+      );
+  }
+  catch (std::runtime_error const &)
+  {
+    thrown = true;
+  }
+
+  bprintf (
+      "Parallel concurrent test: %0%, %1%\n"
+    , identical ? "identical" : "MISMATCH"
+    , thrown    ? "rethrown"  : "MISMATCH"
+    );
+}
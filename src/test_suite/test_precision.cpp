@@ -0,0 +1,56 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <string>
+
+#include "test_cases.hpp"
+
+void test__precision ()
+{
+  test_cases cases ("Precision");
+
+  std::string const text = "Åsaxyz";
+
+  // Precision counts the unit of the width and never splits a UTF-8 sequence
+  cases.check_format ("%0+5u.2%"  , "   Ås"     , text);
+  cases.check_format ("%0-5w.3%|" , "Åsa  |"    , text);
+  cases.check_format ("%0.2%"     , "Å"         , text);
+  cases.check_format ("%0.1%"     , ""          , "Å");
+  cases.check_format ("%0.3%"     , "Ås"        , text);
+  cases.check_format ("%0+4w.3%"  , "  日"      , "日本");
+  // A combining mark is a code point but takes no cell
+  cases.check_format ("%0-6u.2%|" , "e\xCC\x81    |"  , "e\xCC\x81xy");
+  cases.check_format ("%0+6w.2%"  , "    e\xCC\x81x"  , "e\xCC\x81xy");
+
+  // An empty precision is no precision
+  cases.check_format ("%0.%"      , "abcdef"    , "abcdef");
+  cases.check_format ("%0+8.%|"   , "  abcdef|" , std::string ("abcdef"));
+  cases.check_format ("%0.:f%"    , "2.500000"  , 2.5);
+
+  // Width and precision taken from arguments
+  cases.check_format ("%0+{1}%|"        , "    abcdef|"  , "abcdef", 10);
+  cases.check_format ("%0-{1}.{2}%|"    , "abc       |"  , "abcdef", 10, 3);
+  cases.check_format ("%0.{1}:f%"       , "3.142"        , 3.14159265, 3);
+  cases.check_format ("%0+{1}.1:e%"     , "   3.1e+00"   , 3.14159265, 10);
+  cases.check_format ("%0+{1}u.{2}%|"   , "   Ås|"       , text, 5, 2);
+  cases.check_format ("%0+{1}%|"        , "abcdef|"      , "abcdef", -4);
+  cases.check_format ("%0.{1}%|"        , "|"            , "abcdef", 0);
+  cases.check_format ("%0+{3}%|"        , "abcdef|"      , "abcdef", 10);
+
+  cases.report ();
+}
@@ -0,0 +1,101 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include "../bprintf/bprintf.hpp"
+#include "../bprintf/log.hpp"
+#include "../bprintf/recorder.hpp"
+
+#ifdef BPRINTF_ENABLE_RECORDER
+
+namespace
+{
+  struct append_sink
+  {
+    better_printf::chars_type & chars;
+
+    void write (better_printf::chars_type const & chunk)
+    {
+      chars.insert (chars.end (), chunk.begin (), chunk.end ());
+    }
+  };
+}
+
+void test__recorder ()
+{
+  using namespace better_printf;
+
+  auto const path = "exe.bprintf.trace";
+
+  chars_type expected;
+
+  start_recording (path, 1);
+
+  // Recorded by the hooks in bsprintf and bfprintf_streaming
+  bsprintf (expected, "%0% %1:x% %2+8% %3-8%|\n", -1, 0xCAFEU, 3.5, "str");
+  bsprintf (expected, "%0% %1%\n", std::string ("Hello"), "there");
+  bsprintf (expected, "%0:d8t% %1%\n", 150000000LL);
+
+  append_sink sink { expected };
+  bfprintf_streaming (sink, 16, "%0+{1}% %2.{3}:f%\n", "streamed", 24, 3.14159, 2);
+
+  stop_recording ();
+
+  std::vector<trace_record> records;
+  auto loaded = load_trace (path, records);
+
+  chars_type replayed;
+  for (auto & record : records)
+  {
+    replay_record (replayed, record);
+  }
+
+  std::remove (path);
+
+  bprintf (
+      "Recorder test: %0% records %1%\n"
+    , records.size ()
+    , loaded && expected == replayed ? "identical" : "MISMATCH"
+    );
+
+  // A log statement is recorded as its own call only, the level prefix isn't formatted
+  set_log_level (log_level::info);
+
+  start_recording (path, 1);
+  BPRINTF_LOG (info, "Recorder log test: %0%", "logged");
+  stop_recording ();
+
+  std::vector<trace_record> log_records;
+  auto log_loaded = load_trace (path, log_records);
+
+  std::remove (path);
+
+  bprintf (
+      "Recorder log test: %0% records %1%\n"
+    , log_records.size ()
+    , log_loaded && log_records.size () == 1 && log_records.front ().format == "Recorder log test: %0%" ? "identical" : "MISMATCH"
+    );
+}
+
+#else
+
+void test__recorder ()
+{
+  better_printf::bprintf ("Recorder test: skipped, build with BPRINTF_ENABLE_RECORDER\n");
+}
+
+#endif // BPRINTF_ENABLE_RECORDER
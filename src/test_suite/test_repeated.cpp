@@ -0,0 +1,128 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <initializer_list>
+#include <string>
+
+#include "../bprintf/formatters.hpp"
+
+namespace
+{
+  // Formats the same each time and counts how often, a repeated placeholder copies instead
+  struct counted
+  {
+    static int formats;
+  };
+
+  int counted::formats = 0;
+
+  struct collect_sink
+  {
+    better_printf::chars_type & chars;
+
+    void write (better_printf::chars_type const & formatted)
+    {
+      chars.insert (chars.end (), formatted.begin (), formatted.end ());
+    }
+  };
+}
+
+namespace better_printf
+{
+  namespace formatters
+  {
+    void format (
+        details::formatter_context const & context
+      , counted const &
+      )
+    {
+      ++counted::formats;
+      details::push_buffer (context, "{counted}", 9);
+    }
+  }
+}
+
+#include "test_cases.hpp"
+
+namespace
+{
+  // Formats pieces joined into one format, where placeholders repeat and may be copied,
+  //  and each piece on its own, where every placeholder is formatted
+  template<typename ...TArgs>
+  bool check_repeated (
+      std::initializer_list<better_printf::cstr_type> pieces
+    , TArgs const &                                   ...args
+    )
+  {
+    using namespace better_printf;
+
+    std::string format;
+    chars_type  separate;
+
+    for (auto piece : pieces)
+    {
+      format += piece;
+      bsprintf (separate, piece, args...);
+    }
+
+    chars_type joined;
+    bsprintf (joined, format.c_str (), args...);
+
+    // Streaming forgets the formatted arguments on each flush
+    chars_type    streamed;
+    collect_sink  sink { streamed };
+    bfprintf_streaming (sink, 16, format.c_str (), args...);
+
+    if (joined != separate || streamed != separate)
+    {
+      bprintf (
+          "Repeated test: %0% gave '%1%' and streamed '%2%', expected '%3%'\n"
+        , format
+        , std::string (joined.begin (), joined.end ())
+        , std::string (streamed.begin (), streamed.end ())
+        , std::string (separate.begin (), separate.end ())
+        );
+      return false;
+    }
+
+    return true;
+  }
+}
+
+void test__repeated ()
+{
+  test_cases cases ("Repeated");
+
+  std::string const text = "Åsaxyz";
+
+  cases.check (check_repeated ({ "%0+10:e%|", "%1-8.3%|", "%0+10:e%|", "%1-8.3%|", "%0:e%|", "%1%" }, 2.5, text));
+  cases.check (check_repeated ({ "%0%,", "%0+6%,", "%0%,", "%0+6%,", "%0-6u%|" }, "ab"));
+  cases.check (check_repeated ({ "%0%", "%1:f%", "%0%", "%1:f%", "%1.2:f%", "%1:f%" }, counted (), 1.0 / 3.0));
+  cases.check (check_repeated ({ "%0+{1}%|", "%0+{1}%|", "%0+{2}%|", "%0-{1}%|" }, 3.25, 8, 9));
+  cases.check (check_repeated ({ "%0+30%", "%0+30%", "%0+30%" }, std::string ("a long argument to flush")));
+
+  // The custom formatter only runs for the first of the identical placeholders
+  counted::formats = 0;
+
+  better_printf::chars_type chars;
+  better_printf::bsprintf (chars, "%0% %0% %0+12% %0%", counted ());
+
+  cases.check (counted::formats == 2);
+
+  cases.report ();
+}
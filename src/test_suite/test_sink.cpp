@@ -0,0 +1,266 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include "../bprintf/bprintf.hpp"
+#include "../bprintf/sink.hpp"
+
+#ifdef BPRINTF_HAS_MMAP_SINK
+
+#include <thread>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+void test__mmap_file_sink ()
+{
+  using namespace better_printf;
+
+  constexpr auto thread_count     = 4;
+  constexpr auto lines_per_thread = 100;
+
+  std::string const base_path = "exe.bprintf.sink";
+
+  {
+    mmap_file_sink sink (base_path, 1024);
+
+    std::vector<std::thread> threads;
+
+    for (auto t = 0; t < thread_count; ++t)
+    {
+      threads.emplace_back ([&sink, t] ()
+        {
+          for (auto iter = 0; iter < lines_per_thread; ++iter)
+          {
+            bfprintf (sink, "Thread %0% line %1+3%\n", t, iter);
+          }
+        });
+    }
+
+    for (auto & thread : threads)
+    {
+      thread.join ();
+    }
+  }
+
+  // Count the lines written across all rolled files
+  auto files  = 0;
+  auto lines  = 0;
+
+  for (;; ++files)
+  {
+    auto path = base_path + "." + std::to_string (files);
+
+    auto file = std::fopen (path.c_str (), "rb");
+    if (!file)
+    {
+      break;
+    }
+
+    int ch;
+    while ((ch = std::fgetc (file)) != EOF)
+    {
+      if (ch == '\n')
+      {
+        ++lines;
+      }
+    }
+
+    std::fclose (file);
+    std::remove (path.c_str ());
+  }
+
+  bprintf (
+      "mmap_file_sink test: %0% lines in %1% files (expected %2% lines)\n"
+    , lines
+    , files
+    , thread_count * lines_per_thread
+    );
+
+  // A roll that can't open the next file keeps the full one, reports it through is_open ()
+  //  and is retried by the next message that doesn't fit
+  std::string const directory = "exe.bprintf.sink_dir";
+  auto const        rolled    = directory + "/log";
+
+  ::mkdir (directory.c_str (), 0755);
+
+  auto opened     = false;
+  auto failed     = false;
+  auto recovered  = false;
+
+  {
+    mmap_file_sink sink (rolled, 64);
+
+    opened = sink.is_open ();
+
+    bfprintf (sink, "first\n");
+
+    std::remove ((rolled + ".0").c_str ());
+    ::rmdir (directory.c_str ());
+
+    bfprintf (sink, "%0%\n", std::string (100, 'x'));
+    failed = !sink.is_open ();
+
+    ::mkdir (directory.c_str (), 0755);
+
+    bfprintf (sink, "second\n");
+    recovered = sink.is_open ();
+  }
+
+  chars_type retried;
+
+  auto file = std::fopen ((rolled + ".1").c_str (), "rb");
+  int ch;
+  while (file && (ch = std::fgetc (file)) != EOF)
+  {
+    retried.push_back (static_cast<char> (ch));
+  }
+
+  if (file)
+  {
+    std::fclose (file);
+  }
+
+  std::remove ((rolled + ".1").c_str ());
+  ::rmdir (directory.c_str ());
+
+  // Without a file messages are dropped
+  auto missing_open = true;
+
+  {
+    mmap_file_sink sink (rolled, 64);
+
+    missing_open = sink.is_open ();
+
+    bfprintf (sink, "dropped\n");
+  }
+
+  bprintf (
+      "mmap_file_sink roll failure test: %0%\n"
+    , opened && failed && recovered && !missing_open && std::string (retried.begin (), retried.end ()) == "second\n" ? "recovered" : "MISMATCH"
+    );
+}
+
+#else
+
+void test__mmap_file_sink ()
+{
+}
+
+#endif // BPRINTF_HAS_MMAP_SINK
+
+#ifdef BPRINTF_HAS_IO_URING_SINK
+
+#include <fcntl.h>
+#include <unistd.h>
+
+void test__io_uring_sink ()
+{
+  using namespace better_printf;
+
+  auto const path = "exe.bprintf.io_uring";
+
+  chars_type expected;
+  for (auto iter = 0; iter < 1000; ++iter)
+  {
+    bsprintf (expected, "io_uring line %0+4%: %1:x%\n", iter, iter * 31);
+  }
+
+  for (auto use_io_uring : { true, false })
+  {
+    auto fd = ::open (path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    auto used_io_uring = false;
+
+    {
+      // Small buffers to exercise buffer recycling
+      io_uring_sink sink (fd, 256, 4, use_io_uring);
+
+      used_io_uring = sink.uses_io_uring ();
+
+      for (auto iter = 0; iter < 1000; ++iter)
+      {
+        bfprintf (sink, "io_uring line %0+4%: %1:x%\n", iter, iter * 31);
+      }
+    }
+
+    ::close (fd);
+
+    chars_type written;
+
+    auto file = std::fopen (path, "rb");
+    int ch;
+    while (file && (ch = std::fgetc (file)) != EOF)
+    {
+      written.push_back (static_cast<char> (ch));
+    }
+
+    if (file)
+    {
+      std::fclose (file);
+    }
+
+    std::remove (path);
+
+    bprintf (
+        "io_uring_sink test (%0%): %1%\n"
+      , used_io_uring ? "io_uring" : "write fallback"
+      , written == expected ? "identical" : "MISMATCH"
+      );
+  }
+
+  // Writes through fd before and after the sink must land around the sink's output
+  for (auto use_io_uring : { true, false })
+  {
+    auto fd = ::open (path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+    auto used_io_uring = false;
+
+    auto written = ::write (fd, "A", 1);
+
+    {
+      io_uring_sink sink (fd, 256, 4, use_io_uring);
+
+      used_io_uring = sink.uses_io_uring ();
+
+      bfprintf (sink, "BBB");
+    }
+
+    written += ::write (fd, "C", 1);
+
+    char buffer [16] {};
+    auto read = ::pread (fd, buffer, sizeof (buffer) - 1, 0);
+
+    ::close (fd);
+    std::remove (path);
+
+    bprintf (
+        "io_uring_sink position test (%0%): %1%\n"
+      , used_io_uring ? "io_uring" : "write fallback"
+      , written == 2 && read == 5 && std::strcmp (buffer, "ABBBC") == 0 ? "ABBBC" : "MISMATCH"
+      );
+  }
+}
+
+#else
+
+void test__io_uring_sink ()
+{
+}
+
+#endif // BPRINTF_HAS_IO_URING_SINK
@@ -0,0 +1,84 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <string>
+
+#include "../bprintf/bprintf.hpp"
+
+namespace
+{
+  struct chunk_sink
+  {
+    better_printf::chars_type   chars         ;
+    std::size_t                 writes        = 0;
+    std::size_t                 largest_write = 0;
+
+    void write (better_printf::chars_type const & chunk)
+    {
+      chars.insert (chars.end (), chunk.begin (), chunk.end ());
+      ++writes;
+      largest_write = chunk.size () > largest_write ? chunk.size () : largest_write;
+    }
+  };
+}
+
+void test__streaming ()
+{
+  using namespace better_printf;
+
+  constexpr auto threshold = 4096U;
+
+  std::string blob (1000000, 'x');
+
+  auto format = "Blob %0:x%: %1% |%2+{3}%| %1% %0:x% %1-10000%|\n";
+
+  chars_type expected;
+  bsprintf (expected, format, 0xCAFE, blob, "padded", 20000);
+
+  chunk_sink sink;
+  bfprintf_streaming (sink, threshold, format, 0xCAFE, blob, "padded", 20000);
+
+  bprintf (
+      "Streaming test: %0% (%1% bytes in %2% writes, largest %3% <= %4%)\n"
+    , sink.chars == expected && sink.largest_write <= threshold ? "identical" : "MISMATCH"
+    , sink.chars.size ()
+    , sink.writes
+    , sink.largest_write
+    , threshold
+    );
+
+  // Repeated arguments below the threshold are copied from the cache, the copy mustn't cross it
+  std::string repeated (3000, 'y');
+
+  auto repeated_format = "%0%%0%%0%%0%|%1+5%%1+5%\n";
+
+  chars_type repeated_expected;
+  bsprintf (repeated_expected, repeated_format, repeated, 42);
+
+  chunk_sink repeated_sink;
+  bfprintf_streaming (repeated_sink, threshold, repeated_format, repeated, 42);
+
+  bprintf (
+      "Streaming test (repeated): %0% (%1% bytes in %2% writes, largest %3% <= %4%)\n"
+    , repeated_sink.chars == repeated_expected && repeated_sink.largest_write <= threshold ? "identical" : "MISMATCH"
+    , repeated_sink.chars.size ()
+    , repeated_sink.writes
+    , repeated_sink.largest_write
+    , threshold
+    );
+}
@@ -46,7 +46,34 @@ namespace better_printf
   }
 }
 
+enum class TestState
+{
+  idle    ,
+  running ,
+  stopped ,
+};
+
+enum TestSparse
+{
+  sparse_low  = -1  ,
+  sparse_high = 100 ,
+};
+
+enum class TestUnregistered : std::uint8_t
+{
+  value = 7 ,
+};
+
+BPRINTF_ENUM (TestState, idle, running, stopped)
+BPRINTF_ENUM (TestSparse, sparse_low, sparse_high)
+
+// static_bsprintf needs a newer compiler than the rest, the v140 project builds without it
+#ifdef BPRINTF_HAS_CONSTEXPR14
+# include "../bprintf/static_format.hpp"
+#endif
 #include "../bprintf/bprintf.hpp"
+#include "../bprintf/parallel.hpp"
+#include "../bprintf/log.hpp"
 
 namespace
 {
@@ -105,15 +132,153 @@ namespace
 
     return 0;
   }
+
+  int test_sprintf_mixed ()
+  {
+    char buffer [128] {};
+
+    for (auto iter = 0; iter < count; ++iter)
+    {
+      sprintf (buffer, "Row %d: 0x%X %-10s|%10s %f", iter, iter, "left", "right", iter * 0.5);
+    }
+
+    return 0;
+  }
+
+  int test_bsprintf_repeated ()
+  {
+    using namespace better_printf;
+
+    chars_type buffer;
+    buffer.reserve (128);
+
+    for (auto iter = 0; iter < count; ++iter)
+    {
+      buffer.clear ();
+      bsprintf (buffer, "%0+10% = %1% (%1:e%), %0+10% = %1%", "value", iter * 0.5);
+    }
+
+    return 0;
+  }
+
+  int test_bsprintf_enum ()
+  {
+    using namespace better_printf;
+
+    chars_type buffer;
+    buffer.reserve (64);
+
+    for (auto iter = 0; iter < count; ++iter)
+    {
+      buffer.clear ();
+      bsprintf (buffer, "State: %0% %1%", static_cast<TestState> (iter % 3), iter % 2 ? sparse_low : sparse_high);
+    }
+
+    return 0;
+  }
+
+  int test_bsprintf_mixed ()
+  {
+    using namespace better_printf;
+
+    chars_type buffer;
+    buffer.reserve (128);
+
+    for (auto iter = 0; iter < count; ++iter)
+    {
+      buffer.clear ();
+      bsprintf (buffer, "Row %0%: 0x%0:X% %1-10%|%2+10% %3%", iter, "left", "right", iter * 0.5);
+    }
+
+    return 0;
+  }
+
+  int test_log_suppressed ()
+  {
+    for (auto iter = 0; iter < count; ++iter)
+    {
+      BPRINTF_LOG (debug, "Suppressed: %0%", iter);
+    }
+
+    return 0;
+  }
+
+  std::vector<int> create_records ()
+  {
+    std::vector<int> records (count);
+
+    for (auto iter = 0; iter < count; ++iter)
+    {
+      records[iter] = iter;
+    }
+
+    return records;
+  }
+
+  void format_record (better_printf::chars_type & chars, int record)
+  {
+    better_printf::bsprintf (chars, "Row %0+8%: 0x%0:X% %1:d2%\n", record, record * 7);
+  }
+
+  int test_bsprintf_serial ()
+  {
+    using namespace better_printf;
+
+    auto records = create_records ();
+
+    chars_type buffer;
+
+    for (auto record : records)
+    {
+      format_record (buffer, record);
+    }
+
+    return 0;
+  }
+
+  int test_bsprintf_parallel ()
+  {
+    using namespace better_printf;
+
+    auto records = create_records ();
+
+    chars_type buffer;
+
+    bsprintf_parallel (buffer, records.begin (), records.end (), format_record);
+
+    return 0;
+  }
 }
 
 extern void test__linkage ();
+extern void test__mmap_file_sink ();
+extern void test__io_uring_sink ();
+extern void test__parallel ();
+extern void test__recorder ();
+extern void test__log ();
+extern void test__streaming ();
+extern void test__fixed ();
+extern void test__unicode ();
+extern void test__repeated ();
+extern void test__precision ();
+extern void test__enum ();
 
 int main()
 {
   using namespace better_printf;
 
   test__linkage ();
+  test__mmap_file_sink ();
+  test__io_uring_sink ();
+  test__parallel ();
+  test__recorder ();
+  test__log ();
+  test__streaming ();
+  test__fixed ();
+  test__unicode ();
+  test__repeated ();
+  test__precision ();
+  test__enum ();
 
   std::string const something = "Something";
   std::string else_           = "Else";
@@ -135,6 +300,69 @@ int main()
     , 0xCAFE
     );
 
+  bprintf (
+      "Fixed: %0:d8% %1:d8t% %2:d8t,% %3:d2,% %4:d8t%\n"
+    , static_cast<std::int64_t> (123456789012LL)
+    , static_cast<std::int64_t> (-150000000LL)
+    , static_cast<std::uint64_t> (123456789000000000ULL)
+    , 100
+    , 0
+    );
+
+  bprintf (
+      "Repeated: %0% %1+8:e% %0% %1+8:e% %1-8:e%| %2+5% %2%\n"
+    , std::string ("Again")
+    , 2.5
+    , "ab"
+    );
+
+  bprintf (
+      "UTF-8: |%0+6%|%0+6u%|%1-6u%|%1-6w%|%2+12u%|\n"
+    , "Åsa"
+    , "日本"
+    , "naïve café"
+    );
+
+  bprintf ("Escape: 100%% %0%%% done%%, incomplete %0\n", 5);
+
+  bprintf (
+      "Dynamic: |%0+{1}%|%0-{1}.{2}%|%3.{2}:f%|%3+{1}.1:e%|%3.0%|\n"
+    , "abcdef"
+    , 10
+    , 3
+    , 3.14159265
+    );
+
+  bprintf (
+      "Enum: %0% %1-9%|%2+9%| %3% %4% %5%\n"
+    , TestState::idle
+    , TestState::running
+    , TestState::stopped
+    , sparse_low
+    , static_cast<TestState> (5)
+    , TestUnregistered::value
+    );
+
+#ifdef BPRINTF_HAS_CONSTEXPR14
+  constexpr auto banner = static_bsprintf<64> (
+      "Static: bprintf v%0%.%1% %2+6%|%3-6%|0x%4:X%\n"
+    , 1
+    , 2
+    , "abc"
+    , -42
+    , 0xCAFEU
+    );
+
+  static_assert (static_bsprintf<16> ("%0+5u%", "Åsa").size () == 6, "static_bsprintf code point width");
+  static_assert (static_bsprintf<16> ("%0+{1}.{2}%", "abcdef", 6, 2).size () == 6, "static_bsprintf dynamic width");
+  static_assert (static_bsprintf<16> ("a%%b%0%%%", 1).size () == 5, "static_bsprintf escaped prelude");
+  static_assert (static_bsprintf<16> ("a%0", 1).size () == 3, "static_bsprintf incomplete placeholder");
+  static_assert (banner.size () == 42, "static_bsprintf produced an unexpected size");
+
+  bprintf (banner);
+  bprintf ("%0-10%: %1%", "Embedded", banner);
+#endif
+
 #ifdef NDEBUG
   auto measure = [] (char const * name, auto && v)
     {
@@ -148,6 +376,13 @@ int main()
   measure ("sstream"  , test_sstream);
   measure ("sprintf"  , test_sprintf);
   measure ("bsprintf" , test_bsprintf);
+  measure ("sprintf (mixed)"  , test_sprintf_mixed);
+  measure ("bsprintf (mixed)" , test_bsprintf_mixed);
+  measure ("log (suppressed)"  , test_log_suppressed);
+  measure ("bsprintf (repeated)", test_bsprintf_repeated);
+  measure ("bsprintf (enum)"    , test_bsprintf_enum);
+  measure ("bsprintf (serial)"  , test_bsprintf_serial);
+  measure ("bsprintf (parallel)", test_bsprintf_parallel);
 #endif
 
   return 0;
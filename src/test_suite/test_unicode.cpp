@@ -0,0 +1,111 @@
+// ----------------------------------------------------------------------------------------------
+// Copyright 2015 Mårten Rånge
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+// ----------------------------------------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <string>
+
+#include "test_cases.hpp"
+
+namespace
+{
+  // Long enough that the SSE2 code point kernel sums its lanes several times (every 255 blocks of 16 bytes)
+  //  and ends on a partial block handled by the scalar tail
+  std::string repeat (std::string const & unit, std::size_t count, std::string const & tail)
+  {
+    std::string result;
+    result.reserve (unit.size () * count + tail.size ());
+
+    for (auto iter = 0U; iter < count; ++iter)
+    {
+      result += unit;
+    }
+
+    return result + tail;
+  }
+
+  std::size_t scalar_code_points (std::string const & value)
+  {
+    std::size_t count = 0;
+
+    for (auto ch : value)
+    {
+      count += (static_cast<unsigned char> (ch) & 0xC0U) == 0x80U ? 0 : 1;
+    }
+
+    return count;
+  }
+
+  bool check_unicode (
+      better_printf::cstr_type  name
+    , std::string const &       value
+    , std::size_t               expected_code_points
+    , std::size_t               expected_cells
+    )
+  {
+    using namespace better_printf;
+
+    auto code_points  = details::utf8_code_points (value.data (), value.size ());
+    auto cells        = details::utf8_cells       (value.data (), value.size ());
+    auto scalar       = scalar_code_points (value);
+
+    // Padding goes through display_width, 3 fill chars are expected in front of the value
+    chars_type chars;
+    bsprintf (chars, "%0+{1}u%", value, expected_code_points + 3);
+
+    auto padded = std::string (chars.begin (), chars.end ());
+
+    if (
+          code_points != expected_code_points
+      ||  code_points != scalar
+      ||  cells       != expected_cells
+      ||  padded      != "   " + value
+      )
+    {
+      bprintf (
+          "Unicode test: %0% (%1% bytes) gave %2% code points (scalar %3%, expected %4%), %5% cells (expected %6%), %7% padded bytes\n"
+        , name
+        , value.size ()
+        , code_points
+        , scalar
+        , expected_code_points
+        , cells
+        , expected_cells
+        , padded.size ()
+        );
+      return false;
+    }
+
+    return true;
+  }
+}
+
+void test__unicode ()
+{
+  test_cases cases ("Unicode");
+
+  // "Åsa日本" is 10 bytes, 5 code points and 7 cells
+  cases.check (check_unicode ("mixed"       , repeat ("Åsa日本", 1000, "x") , 5001  , 7001));
+  cases.check (check_unicode ("mixed, short", repeat ("Åsa日本", 3   , "")  , 15    , 21));
+  // Every byte starts a code point, each lane reaches 255 before it's summed
+  cases.check (check_unicode ("ascii"       , std::string (255 * 16 * 3 + 7, 'a')      , 12247 , 12247));
+  // Two byte sequences only, half the bytes are continuation bytes
+  cases.check (check_unicode ("latin"       , repeat ("é", 255 * 16, "")                , 4080  , 4080));
+  // Three byte sequences, continuation bytes dominate the blocks
+  cases.check (check_unicode ("wide"        , repeat ("日", 255 * 8 + 1, "")            , 2041  , 4082));
+
+  cases.report ();
+}